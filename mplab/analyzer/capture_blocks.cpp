@@ -0,0 +1,396 @@
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <zlib.h>
+#include "app.h"
+#include "fifo.h"
+#include "uart.h"
+#include "timestamp.h"
+#include "capture.h"
+#include "capture_blocks.h"
+
+namespace galaxy {
+
+static const char kFileMagic[4] = { 'G', 'C', 'B', '1' };
+static const char kBlockMagic[4] = { 'G', 'B', 'L', 'K' };
+static const char kIndexMagic[4] = { 'G', 'C', 'B', 'I' };
+
+static void Put32(uint8_t* p, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = uint8_t(value >> (8 * i));
+    }
+}
+
+static void Put64(uint8_t* p, uint64_t value) {
+    Put32(p, uint32_t(value));
+    Put32(p + 4, uint32_t(value >> 32));
+}
+
+static uint32_t Get32(const uint8_t* p) {
+    return uint32_t(p[0]) | (uint32_t(p[1]) << 8) | (uint32_t(p[2]) << 16) | (uint32_t(p[3]) << 24);
+}
+
+static uint64_t Get64(const uint8_t* p) {
+    return Get32(p) | (uint64_t(Get32(p + 4)) << 32);
+}
+
+static bool Fail(std::string& error, const std::string& path, const char* what) {
+    error = path + ": " + what + (errno ? std::string(": ") + strerror(errno) : std::string());
+    return false;
+}
+
+//
+// Writer
+//
+
+BlockWriter::~BlockWriter() {
+    std::string ignored;
+    Close(ignored);
+}
+
+bool BlockWriter::Open(const std::string& path, uint32_t blockWords, int level, std::string& error) {
+    uint8_t header[BLOCK_FILE_HEADER_SIZE] = {};
+    uint8_t indexHeader[BLOCK_INDEX_HEADER_SIZE] = {};
+
+    blockWords_ = blockWords;
+    level_ = level;
+    errno = 0;
+    data_ = fopen(path.c_str(), "wb");
+    if (!data_) {
+        return Fail(error, path, "create");
+    }
+    index_ = fopen((path + "i").c_str(), "wb");
+    if (!index_) {
+        Fail(error, path + "i", "create");
+        // Close sees a writer that never opened
+        fclose(data_);
+        data_ = nullptr;
+        return false;
+    }
+
+    memcpy(header, kFileMagic, 4);
+    Put32(header + 4, TIMESTAMP_TICKS_PER_US);
+    Put32(header + 8, blockWords_);
+    memcpy(indexHeader, kIndexMagic, 4);
+    Put32(indexHeader + 4, BLOCK_INDEX_ENTRY_SIZE);
+    // Block count goes in at Close, a reader of an unfinished index counts entries
+    fwrite(header, 1, sizeof(header), data_);
+    fwrite(indexHeader, 1, sizeof(indexHeader), index_);
+    offset_ = sizeof(header);
+    return true;
+}
+
+void BlockWriter::OnWords(const CaptureWord* words, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        Add(words[i]);
+    }
+}
+
+// The words either side of a gap do not follow on, so start a new block
+void BlockWriter::OnGap(unsigned int packets) {
+    (void)packets;
+    Flush();
+    pendingFlags_ |= BLOCK_FLAG_GAP;
+}
+
+void BlockWriter::Add(const CaptureWord& word) {
+    size_t count = words_ - entry_.firstWord;
+    uint64_t delta = 0;
+
+    if (!raw_.empty()) {
+        delta = word.stamp - entry_.lastStamp;
+        // Cut on the first address word after the target size, so blocks
+        // start with a whole frame, but never let a block run away
+        if ((count >= blockWords_ && (word.word & (GALAXY_ADDRESS_FLAG | GALAXY_FAULT_MASK))) ||
+                count >= 2 * size_t(blockWords_) || delta > 0xFFFFFFFFULL) {
+            Flush();
+            delta = 0;
+        }
+    }
+    if (raw_.empty()) {
+        entry_.offset = offset_;
+        entry_.firstStamp = word.stamp;
+        entry_.firstWord = words_;
+        entry_.words = 0;
+        entry_.flags = pendingFlags_;
+        memset(entry_.addresses, 0, sizeof(entry_.addresses));
+        pendingFlags_ = 0;
+        // Flags must match what decoding this block alone finds
+        GalaxyDecoderInitialize(&decoder_);
+    }
+
+    unsigned int code = delta == 0 ? 0 : delta <= 0xFF ? 1 : delta <= 0xFFFF ? 2 : 3;
+    unsigned int bytes = code == 3 ? 4 : code;
+    raw_.push_back(uint8_t(word.word));
+    raw_.push_back(uint8_t(((word.word >> 8) & 0x0F) | (code << BLOCK_DELTA_CODE_SHIFT)));
+    for (unsigned int k = 0; k < bytes; k++) {
+        raw_.push_back(uint8_t(delta >> (8 * k)));
+    }
+
+    if (word.word & UART_FAULT_FRAMING_ERROR) {
+        entry_.flags |= BLOCK_FLAG_FRAMING;
+    }
+    if (word.word & UART_FAULT_OVERRUN_ERROR) {
+        entry_.flags |= BLOCK_FLAG_OVERRUN;
+    }
+    if ((word.word & (GALAXY_ADDRESS_FLAG | GALAXY_FAULT_MASK)) == GALAXY_ADDRESS_FLAG) {
+        entry_.addresses[(word.word >> 3) & 0x1F] |= uint8_t(1 << (word.word & 7));
+    }
+    switch (GalaxyDecode(&decoder_, word.word, word.stamp)) {
+        case GALAXY_DECODE_FRAME:
+            GalaxyFrameRelease(&decoder_);
+            break;
+        case GALAXY_DECODE_CRC_ERROR:
+            entry_.flags |= BLOCK_FLAG_CRC;
+            break;
+        case GALAXY_DECODE_LENGTH_ERROR:
+            entry_.flags |= BLOCK_FLAG_LENGTH;
+            break;
+        case GALAXY_DECODE_FAULT:
+            entry_.flags |= BLOCK_FLAG_FAULT;
+            break;
+        default:
+            break;
+    }
+
+    entry_.lastStamp = word.stamp;
+    entry_.words++;
+    words_++;
+}
+
+void BlockWriter::Flush() {
+    uint8_t header[BLOCK_HEADER_SIZE] = {};
+    uint8_t entry[BLOCK_INDEX_ENTRY_SIZE] = {};
+    const uint8_t* stored = raw_.data();
+    size_t storedSize = raw_.size();
+    uint8_t codec = BLOCK_CODEC_RAW;
+
+    if (raw_.empty() || !data_) {
+        return;
+    }
+    if (level_ > 0) {
+        uLongf size = compressBound(raw_.size());
+        stored_.resize(size);
+        // Kept raw when deflate does not help
+        if (compress2(stored_.data(), &size, raw_.data(), raw_.size(), level_) == Z_OK && size < raw_.size()) {
+            stored = stored_.data();
+            storedSize = size;
+            codec = BLOCK_CODEC_DEFLATE;
+        }
+    }
+
+    memcpy(header, kBlockMagic, 4);
+    header[4] = codec;
+    Put32(header + 8, entry_.words);
+    Put32(header + 12, uint32_t(raw_.size()));
+    Put32(header + 16, uint32_t(storedSize));
+    Put64(header + 20, entry_.firstStamp);
+    Put32(header + 28, uint32_t(crc32(0, stored, storedSize)));
+    if (fwrite(header, 1, sizeof(header), data_) != sizeof(header) ||
+            fwrite(stored, 1, storedSize, data_) != storedSize) {
+        failed_ = true;
+    }
+
+    Put64(entry, entry_.offset);
+    Put64(entry + 8, entry_.firstStamp);
+    Put64(entry + 16, entry_.lastStamp);
+    Put64(entry + 24, entry_.firstWord);
+    Put32(entry + 32, entry_.words);
+    Put32(entry + 36, entry_.flags);
+    memcpy(entry + 40, entry_.addresses, sizeof(entry_.addresses));
+    if (fwrite(entry, 1, sizeof(entry), index_) != sizeof(entry)) {
+        failed_ = true;
+    }
+
+    offset_ += sizeof(header) + storedSize;
+    rawBytes_ += raw_.size();
+    storedBytes_ += storedSize;
+    blocks_++;
+    raw_.clear();
+}
+
+bool BlockWriter::Close(std::string& error) {
+    uint8_t count[8];
+
+    if (!data_ || !index_) {
+        return true;
+    }
+    Flush();
+    Put64(count, blocks_);
+    if (fseek(index_, 8, SEEK_SET) != 0 || fwrite(count, 1, sizeof(count), index_) != sizeof(count)) {
+        failed_ = true;
+    }
+    if (fclose(data_) != 0) {
+        failed_ = true;
+    }
+    if (fclose(index_) != 0) {
+        failed_ = true;
+    }
+    data_ = nullptr;
+    index_ = nullptr;
+    if (failed_) {
+        error = "write failed";
+        return false;
+    }
+    return true;
+}
+
+//
+// Reader
+//
+
+static const uint8_t* Map(const std::string& path, size_t& size, std::string& error) {
+    struct stat st;
+    void* map = nullptr;
+    int fd;
+
+    errno = 0;
+    fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        Fail(error, path, "open");
+        return nullptr;
+    }
+    if (fstat(fd, &st) != 0 || st.st_size == 0) {
+        Fail(error, path, "empty or unreadable");
+    } else {
+        size = size_t(st.st_size);
+        map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            Fail(error, path, "mmap");
+            map = nullptr;
+        }
+    }
+    close(fd);
+    return static_cast<const uint8_t*>(map);
+}
+
+BlockFile::~BlockFile() {
+    if (data_) {
+        munmap(const_cast<uint8_t*>(data_), dataSize_);
+    }
+    if (index_) {
+        munmap(const_cast<uint8_t*>(index_), indexSize_);
+    }
+}
+
+bool BlockFile::IsBlockFile(const std::string& path) {
+    char magic[4];
+    FILE* f = fopen(path.c_str(), "rb");
+    bool match = false;
+
+    if (f) {
+        match = fread(magic, 1, 4, f) == 4 && memcmp(magic, kFileMagic, 4) == 0;
+        fclose(f);
+    }
+    return match;
+}
+
+bool BlockFile::Open(const std::string& path, std::string& error) {
+    if (!(data_ = Map(path, dataSize_, error)) || !(index_ = Map(path + "i", indexSize_, error))) {
+        return false;
+    }
+    errno = 0;
+    if (dataSize_ < BLOCK_FILE_HEADER_SIZE || memcmp(data_, kFileMagic, 4) != 0) {
+        return Fail(error, path, "not a block capture file");
+    }
+    if (indexSize_ < BLOCK_INDEX_HEADER_SIZE || memcmp(index_, kIndexMagic, 4) != 0 ||
+            Get32(index_ + 4) != BLOCK_INDEX_ENTRY_SIZE) {
+        return Fail(error, path + "i", "not a block capture index");
+    }
+    ticksPerUs_ = Get32(data_ + 4);
+    blocks_ = (indexSize_ - BLOCK_INDEX_HEADER_SIZE) / BLOCK_INDEX_ENTRY_SIZE;
+    if (Get64(index_ + 8) != 0 && Get64(index_ + 8) < blocks_) {
+        blocks_ = Get64(index_ + 8);
+    }
+    return true;
+}
+
+BlockIndexEntry BlockFile::Entry(uint64_t block) const {
+    const uint8_t* p = index_ + BLOCK_INDEX_HEADER_SIZE + block * BLOCK_INDEX_ENTRY_SIZE;
+    BlockIndexEntry entry;
+
+    entry.offset = Get64(p);
+    entry.firstStamp = Get64(p + 8);
+    entry.lastStamp = Get64(p + 16);
+    entry.firstWord = Get64(p + 24);
+    entry.words = Get32(p + 32);
+    entry.flags = Get32(p + 36);
+    memcpy(entry.addresses, p + 40, sizeof(entry.addresses));
+    return entry;
+}
+
+uint64_t BlockFile::FindStamp(uint64_t stamp) const {
+    uint64_t low = 0;
+    uint64_t high = blocks_;
+
+    while (low < high) {
+        uint64_t middle = low + (high - low) / 2;
+        if (Get64(index_ + BLOCK_INDEX_HEADER_SIZE + middle * BLOCK_INDEX_ENTRY_SIZE + 16) < stamp) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+bool BlockFile::ReadBlock(uint64_t block, std::vector<CaptureWord>& words, std::string& error) const {
+    BlockIndexEntry entry = Entry(block);
+    std::vector<uint8_t> inflated;
+
+    words.clear();
+    if (entry.offset + BLOCK_HEADER_SIZE > dataSize_ || memcmp(data_ + entry.offset, kBlockMagic, 4) != 0) {
+        error = "block " + std::to_string(block) + ": bad header";
+        return false;
+    }
+    const uint8_t* header = data_ + entry.offset;
+    const uint8_t* stored = header + BLOCK_HEADER_SIZE;
+    uint32_t count = Get32(header + 8);
+    uint32_t rawSize = Get32(header + 12);
+    uint32_t storedSize = Get32(header + 16);
+    uint64_t stamp = Get64(header + 20);
+
+    if (entry.offset + BLOCK_HEADER_SIZE + storedSize > dataSize_ ||
+            crc32(0, stored, storedSize) != Get32(header + 28)) {
+        error = "block " + std::to_string(block) + ": bad CRC";
+        return false;
+    }
+    const uint8_t* raw = stored;
+    if (header[4] == BLOCK_CODEC_DEFLATE) {
+        uLongf size = rawSize;
+        inflated.resize(rawSize);
+        if (uncompress(inflated.data(), &size, stored, storedSize) != Z_OK || size != rawSize) {
+            error = "block " + std::to_string(block) + ": bad deflate data";
+            return false;
+        }
+        raw = inflated.data();
+    } else if (header[4] != BLOCK_CODEC_RAW || rawSize != storedSize) {
+        error = "block " + std::to_string(block) + ": unknown codec";
+        return false;
+    }
+
+    words.reserve(count);
+    for (uint32_t i = 0; i + 2 <= rawSize && words.size() < count;) {
+        unsigned int word = raw[i] | ((raw[i + 1] & 0x0F) << 8);
+        unsigned int code = (raw[i + 1] >> BLOCK_DELTA_CODE_SHIFT) & 0x03;
+        unsigned int bytes = code == 3 ? 4 : code;
+        uint64_t delta = 0;
+
+        i += 2;
+        for (unsigned int k = 0; k < bytes && i < rawSize; k++) {
+            delta |= uint64_t(raw[i++]) << (8 * k);
+        }
+        stamp += delta;
+        words.push_back(CaptureWord{ word, stamp });
+    }
+    if (words.size() != count) {
+        error = "block " + std::to_string(block) + ": truncated";
+        return false;
+    }
+    return true;
+}
+
+}  // namespace galaxy
@@ -0,0 +1,146 @@
+/*
+ * File:   capture_blocks.h
+ *
+ * Block capture file, for seeking in long recordings. Words are stored in
+ * blocks of about BLOCK_WORDS_DEFAULT, each starting on an address word
+ * with its own absolute timestamp, so any block decodes on its own. Blocks
+ * may be deflate compressed. All fields are little endian.
+ *
+ *   file header         "GCB1", u32 ticks per us, u32 block words, u32 0
+ *   block header        "GBLK", u8 codec, 3 bytes 0, u32 words,
+ *                       u32 raw size, u32 stored size, u64 first stamp,
+ *                       u32 CRC-32 of the stored bytes
+ *   block data          one record per word:
+ *                           word low byte
+ *                           bits 0-3 word bits 8-11, bits 4-5 delta code
+ *                           delta, 0, 1, 2 or 4 bytes for code 0-3,
+ *                           timestamp units since the previous word
+ *
+ * The sidecar index, the file name plus "i", has a header and one fixed
+ * size entry per block:
+ *
+ *   index header        "GCBI", u32 entry size, u64 block count
+ *   entry               u64 block offset, u64 first stamp, u64 last stamp,
+ *                       u64 words before the block, u32 words,
+ *                       u32 BLOCK_FLAG_ bits, 32 bytes bitmap of the
+ *                       address words seen, by low byte
+ */
+
+#ifndef CAPTURE_BLOCKS_H
+#define	CAPTURE_BLOCKS_H
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "app.h"
+#include "galaxy.h"
+#include "capture_parser.h"
+
+namespace galaxy {
+
+const uint32_t BLOCK_WORDS_DEFAULT = 4096;
+
+const size_t BLOCK_FILE_HEADER_SIZE = 16;
+const size_t BLOCK_HEADER_SIZE = 32;
+const size_t BLOCK_INDEX_HEADER_SIZE = 16;
+const size_t BLOCK_INDEX_ENTRY_SIZE = 72;
+
+const unsigned int BLOCK_DELTA_CODE_SHIFT = 4;
+
+const uint8_t BLOCK_CODEC_RAW = 0;
+const uint8_t BLOCK_CODEC_DEFLATE = 1;
+
+// Index entry flags: something worth jumping to happened in the block
+const uint32_t BLOCK_FLAG_CRC = 0x01;
+const uint32_t BLOCK_FLAG_LENGTH = 0x02;
+const uint32_t BLOCK_FLAG_FAULT = 0x04;         // UART fault inside a frame
+const uint32_t BLOCK_FLAG_FRAMING = 0x08;
+const uint32_t BLOCK_FLAG_OVERRUN = 0x10;
+const uint32_t BLOCK_FLAG_GAP = 0x20;           // Capture packets lost before the block
+const uint32_t BLOCK_FLAG_ERRORS = 0x3F;
+
+struct BlockIndexEntry {
+    uint64_t offset;
+    uint64_t firstStamp;
+    uint64_t lastStamp;
+    uint64_t firstWord;
+    uint32_t words;
+    uint32_t flags;
+    uint8_t addresses[32];
+
+    bool HasAddress(unsigned int address) const {
+        return addresses[address >> 3] & (1 << (address & 7));
+    }
+};
+
+// Takes words from a CaptureParser and writes the block file and index
+class BlockWriter : public CaptureListener {
+public:
+    BlockWriter() {}
+    ~BlockWriter();
+
+    // level 0 stores blocks uncompressed
+    bool Open(const std::string& path, uint32_t blockWords, int level, std::string& error);
+    bool Close(std::string& error);
+
+    void OnWords(const CaptureWord* words, size_t count) override;
+    void OnGap(unsigned int packets) override;
+
+    uint64_t Blocks() const { return blocks_; }
+    uint64_t Words() const { return words_; }
+    uint64_t RawBytes() const { return rawBytes_; }
+    uint64_t StoredBytes() const { return storedBytes_; }
+
+private:
+    void Add(const CaptureWord& word);
+    void Flush();
+
+    FILE* data_ = nullptr;
+    FILE* index_ = nullptr;
+    bool failed_ = false;
+    uint32_t blockWords_ = BLOCK_WORDS_DEFAULT;
+    int level_ = 0;
+    galaxyDecoder decoder_;
+    std::vector<uint8_t> raw_;
+    std::vector<uint8_t> stored_;
+    BlockIndexEntry entry_ = {};
+    uint64_t offset_ = 0;
+    uint64_t blocks_ = 0;
+    uint64_t words_ = 0;
+    uint64_t rawBytes_ = 0;
+    uint64_t storedBytes_ = 0;
+    uint32_t pendingFlags_ = 0;
+};
+
+// Read side: both files are mapped, blocks are decoded on demand
+class BlockFile {
+public:
+    BlockFile() {}
+    ~BlockFile();
+
+    bool Open(const std::string& path, std::string& error);
+
+    uint64_t Blocks() const { return blocks_; }
+    BlockIndexEntry Entry(uint64_t block) const;
+    double TicksPerUs() const { return ticksPerUs_; }
+
+    // First block whose last stamp is at or after stamp
+    uint64_t FindStamp(uint64_t stamp) const;
+
+    bool ReadBlock(uint64_t block, std::vector<CaptureWord>& words, std::string& error) const;
+
+    static bool IsBlockFile(const std::string& path);
+
+private:
+    const uint8_t* data_ = nullptr;
+    size_t dataSize_ = 0;
+    const uint8_t* index_ = nullptr;
+    size_t indexSize_ = 0;
+    uint64_t blocks_ = 0;
+    double ticksPerUs_ = 1;
+};
+
+}  // namespace galaxy
+
+#endif	/* CAPTURE_BLOCKS_H */
@@ -0,0 +1,76 @@
+#include <cerrno>
+#include <cstring>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "capture_input.h"
+
+namespace galaxy {
+
+static bool Fail(std::string& error, const std::string& path, const char* what) {
+    error = path + ": " + what + ": " + strerror(errno);
+    return false;
+}
+
+static bool ParseMapped(int fd, size_t size, const std::string& path, CaptureParser& parser, std::string& error) {
+    if (size == 0) {
+        return true;
+    }
+    void* map = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+        return Fail(error, path, "mmap");
+    }
+    madvise(map, size, MADV_SEQUENTIAL);
+    parser.Feed(static_cast<const uint8_t*>(map), size, true);
+    munmap(map, size);
+    return true;
+}
+
+// Whatever the parser leaves, a packet split across two reads, moves to
+// the front of the buffer ahead of the next read
+static bool ParseStream(int fd, const std::string& path, CaptureParser& parser, std::string& error) {
+    std::vector<uint8_t> buffer(CAPTURE_INPUT_CHUNK + CaptureParser::kMaxPacket);
+    size_t held = 0;
+
+    for (;;) {
+        ssize_t got = read(fd, buffer.data() + held, CAPTURE_INPUT_CHUNK);
+        if (got < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return Fail(error, path, "read");
+        }
+        size_t length = held + size_t(got);
+        size_t used = parser.Feed(buffer.data(), length, got == 0);
+        held = length - used;
+        if (got == 0) {
+            return true;
+        }
+        memmove(buffer.data(), buffer.data() + used, held);
+    }
+}
+
+bool ParseCaptureFile(const std::string& path, CaptureParser& parser, std::string& error) {
+    int fd = path == "-" ? STDIN_FILENO : open(path.c_str(), O_RDONLY);
+    struct stat st;
+    bool ok;
+
+    if (fd < 0) {
+        return Fail(error, path, "open");
+    }
+    if (fstat(fd, &st) != 0) {
+        ok = Fail(error, path, "stat");
+    } else if (S_ISREG(st.st_mode)) {
+        ok = ParseMapped(fd, size_t(st.st_size), path, parser, error);
+    } else {
+        ok = ParseStream(fd, path, parser, error);
+    }
+    if (fd != STDIN_FILENO) {
+        close(fd);
+    }
+    return ok;
+}
+
+}  // namespace galaxy
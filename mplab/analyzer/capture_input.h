@@ -0,0 +1,24 @@
+/*
+ * File:   capture_input.h
+ *
+ * Feeds a capture file to a CaptureParser. Regular files are mapped and
+ * parsed in place, pipes and "-" (stdin) are read in CAPTURE_INPUT_CHUNK
+ * blocks, so captures of any size run in constant memory.
+ */
+
+#ifndef CAPTURE_INPUT_H
+#define	CAPTURE_INPUT_H
+
+#include <string>
+#include "capture_parser.h"
+
+namespace galaxy {
+
+const size_t CAPTURE_INPUT_CHUNK = 1 << 20;
+
+// False with a message in error if the file cannot be read
+bool ParseCaptureFile(const std::string& path, CaptureParser& parser, std::string& error);
+
+}  // namespace galaxy
+
+#endif	/* CAPTURE_INPUT_H */
@@ -0,0 +1,121 @@
+#include <cstring>
+#include "app.h"
+#include "galaxy.h"
+#include "host.h"
+#include "capture.h"
+#include "capture_parser.h"
+
+namespace galaxy {
+
+bool CaptureParser::CheckCrc(const uint8_t* packet, size_t length) const {
+    unsigned short crc = GALAXY_CRC_INITIAL;
+    for (size_t i = 1; i < length - 2; i++) {
+        crc = crc_update(crc, packet[i]);
+    }
+    return packet[length - 2] == (crc >> 8) && packet[length - 1] == (crc & 0xFF);
+}
+
+size_t CaptureParser::Feed(const uint8_t* data, size_t length, bool final) {
+    size_t i = 0;
+
+    while (i < length) {
+        const uint8_t* sync = static_cast<const uint8_t*>(memchr(data + i, HOST_SYNC, length - i));
+        if (!sync) {
+            stats_.skippedBytes += length - i;
+            i = length;
+            break;
+        }
+        stats_.skippedBytes += (sync - data) - i;
+        i = sync - data;
+
+        if (length - i < 3 || length - i < size_t(data[i + 2]) + HOST_PACKET_OVERHEAD) {
+            if (!final) {
+                break;
+            }
+            stats_.truncated += length - i;
+            i = length;
+            break;
+        }
+
+        size_t packetLength = size_t(data[i + 2]) + HOST_PACKET_OVERHEAD;
+        if (!CheckCrc(data + i, packetLength)) {
+            // Resync on the next sync byte, which may be inside this one
+            stats_.crcErrors++;
+            stats_.skippedBytes++;
+            i++;
+            continue;
+        }
+
+        stats_.packets++;
+        if (data[i + 1] == HOST_PACKET_CAPTURE) {
+            stats_.capturePackets++;
+            CapturePacket(data + i + 3, data[i + 2]);
+        } else {
+            stats_.otherPackets++;
+        }
+        i += packetLength;
+    }
+
+    stats_.bytes += i;
+    return i;
+}
+
+void CaptureParser::CapturePacket(const uint8_t* payload, size_t length) {
+    CaptureWord words[(kMaxPacket - HOST_PACKET_OVERHEAD) / CAPTURE_RECORD_MIN_SIZE];
+    size_t count = 0;
+
+    if (length < CAPTURE_HEADER_SIZE) {
+        stats_.malformed++;
+        return;
+    }
+
+    if (haveSequence_ && payload[0] != uint8_t(sequence_ + 1)) {
+        unsigned int lost = uint8_t(payload[0] - sequence_ - 1);
+        stats_.sequenceGaps += lost;
+        listener_.OnGap(lost);
+    }
+    haveSequence_ = true;
+    sequence_ = payload[0];
+
+    // The base stamp is 32 bits, carry the wraps into the high half
+    uint32_t base = uint32_t(payload[1]) | (uint32_t(payload[2]) << 8) |
+                    (uint32_t(payload[3]) << 16) | (uint32_t(payload[4]) << 24);
+    uint64_t stamp = haveStamp_ ? lastStamp_ + uint32_t(base - uint32_t(lastStamp_)) : base;
+    haveStamp_ = true;
+
+    size_t i = CAPTURE_HEADER_SIZE;
+    bool truncated = false;
+    while (i + CAPTURE_RECORD_MIN_SIZE <= length) {
+        unsigned int word = payload[i] | ((payload[i + 1] & CAPTURE_CONTROL_BIT8) ? GALAXY_ADDRESS_FLAG : 0);
+        uint32_t delta = payload[i + 1] & CAPTURE_ESCAPE;
+
+        i += 2;
+        if (delta == CAPTURE_ESCAPE) {
+            if (i >= length || i + 1 + ((payload[i] >> CAPTURE_DELTA_SHIFT) & 0x03) > length) {
+                truncated = true;
+                break;
+            }
+            unsigned int deltaBytes = (payload[i] >> CAPTURE_DELTA_SHIFT) & 0x03;
+            word = (word & 0xFF) | ((payload[i] & 0x0F) << 8);
+            i++;
+            delta = 0;
+            for (unsigned int k = 0; k < deltaBytes; k++) {
+                delta |= uint32_t(payload[i++]) << (8 * k);
+            }
+        }
+        stamp += uint64_t(delta) << CAPTURE_DELTA_UNIT_SHIFT;
+        words[count].word = word;
+        words[count].stamp = stamp;
+        count++;
+    }
+    if (truncated || i != length) {
+        stats_.malformed++;
+    }
+    lastStamp_ = stamp;
+
+    if (count) {
+        listener_.OnWords(words, count);
+    }
+}
+
+}  // namespace galaxy
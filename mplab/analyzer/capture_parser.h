@@ -0,0 +1,71 @@
+/*
+ * File:   capture_parser.h
+ *
+ * Splits a raw UART2 byte stream, as logged from the debugger's host port,
+ * into host packets and unpacks HOST_PACKET_CAPTURE records into words
+ * with 64 bit timestamps. Bytes that do not start a packet with a good CRC
+ * are skipped one at a time, the same way HostService resyncs.
+ */
+
+#ifndef CAPTURE_PARSER_H
+#define	CAPTURE_PARSER_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace galaxy {
+
+struct CaptureWord {
+    unsigned int word;                      // Bits 0-8 word, 9-11 UART fault flags
+    uint64_t stamp;                         // Timestamp units, extended past 32 bits
+};
+
+// Receives each capture packet's words in bus order
+class CaptureListener {
+public:
+    virtual ~CaptureListener() {}
+    virtual void OnWords(const CaptureWord* words, size_t count) = 0;
+    // Capture packets were lost, the next word does not follow the last one
+    virtual void OnGap(unsigned int packets) = 0;
+};
+
+struct CaptureLinkStats {
+    uint64_t bytes = 0;
+    uint64_t packets = 0;                   // Good CRC, any type
+    uint64_t capturePackets = 0;
+    uint64_t otherPackets = 0;
+    uint64_t crcErrors = 0;                 // Sync byte followed by a bad packet
+    uint64_t skippedBytes = 0;              // Not part of a good packet
+    uint64_t sequenceGaps = 0;              // Capture packets lost
+    uint64_t malformed = 0;                 // Capture payload that does not parse
+    uint64_t truncated = 0;                 // Bytes of a packet cut off at the end
+};
+
+class CaptureParser {
+public:
+    explicit CaptureParser(CaptureListener& listener) : listener_(listener) {}
+
+    // Parses whole packets from data and returns the bytes consumed. The
+    // rest, at most one packet, must be passed again with more data after
+    // it. With final set everything is consumed.
+    size_t Feed(const uint8_t* data, size_t length, bool final);
+
+    const CaptureLinkStats& Stats() const { return stats_; }
+
+    static const size_t kMaxPacket = 3 + 255 + 2;
+
+private:
+    bool CheckCrc(const uint8_t* packet, size_t length) const;
+    void CapturePacket(const uint8_t* payload, size_t length);
+
+    CaptureListener& listener_;
+    CaptureLinkStats stats_;
+    bool haveSequence_ = false;
+    uint8_t sequence_ = 0;
+    bool haveStamp_ = false;
+    uint64_t lastStamp_ = 0;
+};
+
+}  // namespace galaxy
+
+#endif	/* CAPTURE_PARSER_H */
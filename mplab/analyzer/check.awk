@@ -0,0 +1,148 @@
+# make check: reads, in order, galaxysim's summary, galaxyan -a on the
+# capture galaxysim wrote, galaxyan -a on the galaxyidx block file made
+# from it, then galaxyidx info and find on that block file.
+#
+# Fails unless galaxyan decodes every word that was sent, finds no link or
+# frame errors, and times each poll response to within the capture's 8 us
+# resolution. galaxysim starts a response GAP / 2 us after the poll, and
+# the latency runs to the response's first stop bit.
+#
+# The block file must decode to the same words, frames, addresses and
+# latencies. galaxyidx info must count the same words with no error
+# blocks. find must turn up as many frames per address as galaxyan, no
+# errors, and from SEEK seconds on the first frame after it.
+#
+#   awk -v gap=us -v baud=rate -v seek=seconds -f check.awk \
+#       galaxysim.out galaxyan.out blocks.out galaxyidx.out
+
+function fail(message) {
+    print "check: " message
+    failed = 1
+}
+
+BEGIN {
+    latency = gap / 2 + 11e6 / baud
+}
+
+FNR == 1 {
+    file++
+}
+
+file == 1 {
+    if ($1 == "capture" && $3 == "records") {
+        sent = $2
+    }
+    next
+}
+
+# galaxyan lines both decodes must agree on
+file >= 2 && file <= 3 && ($1 == "words" || $1 == "frames" || $1 == "address" || $1 == "slot") {
+    report[file, ++lines[file]] = $0
+}
+
+file == 3 {
+    next
+}
+
+file == 2 && $1 == "words" {
+    words = $2 + 0
+}
+
+file == 2 && $1 == "frames" {
+    good = $2 + 0
+    errors += $4 + $7 + $10 + $12
+}
+
+file == 2 && $1 == "host" && $2 == "link" {
+    errors += $9 + $12
+}
+
+file == 2 && /capture packets lost/ {
+    errors += $1 + $5 + $7
+}
+
+file == 2 && $1 == "address" {
+    frames[$2] = $3
+}
+
+file == 2 && $1 == "slot" {
+    slots++
+    if ($7 != 0) {
+        fail("slot " $2 " has " $7 " timeouts")
+    }
+    for (i = 1; i < NF; i++) {
+        if ($i == "mean" && ($(i + 1) < latency - 8 || $(i + 1) > latency + 8)) {
+            fail("slot " $2 " latency " $(i + 1) " us, expected " latency)
+        }
+    }
+}
+
+file == 2 {
+    next
+}
+
+# galaxyidx info, then "find <address> <found ...>", "find errors <found
+# ...>" and "seek <first frame line>"
+$1 == "blocks" && $2 == "with" {
+    if ($4 + $6 + $8 + $10 + $12 + $14 != 0) {
+        fail("galaxyidx info reports error blocks: " $0)
+    }
+}
+
+$2 == "words" && $3 == "in" && $5 == "blocks," && $7 == "s" {
+    indexed = $1
+}
+
+$1 == "find" && $2 == "errors" {
+    if ($3 != 0) {
+        fail("galaxyidx find -e found " $3)
+    }
+    next
+}
+
+$1 == "find" {
+    found[$2] = $3
+}
+
+$1 == "seek" {
+    seeked = $2
+}
+
+END {
+    if (sent == "" || words != sent) {
+        fail(words " words decoded, galaxysim sent " sent)
+    }
+    if (good == 0 || errors != 0) {
+        fail(good " good frames and " errors " errors")
+    }
+    if (slots == 0) {
+        fail("no poll latency reported")
+    }
+
+    if (lines[2] != lines[3]) {
+        fail("block file report has " lines[3] " lines, capture " lines[2])
+    } else {
+        for (i = 1; i <= lines[2]; i++) {
+            if (report[2, i] != report[3, i]) {
+                fail("block file decodes to \"" report[3, i] "\", capture to \"" report[2, i] "\"")
+            }
+        }
+    }
+    if (indexed != words) {
+        fail("galaxyidx info counts " indexed " words, galaxyan " words)
+    }
+    for (a in frames) {
+        if (found[a] != frames[a]) {
+            fail("galaxyidx find -a " a " found " found[a] " frames, galaxyan " frames[a])
+        }
+    }
+    if (seeked == "" || seeked < seek || seeked > seek + 0.1) {
+        fail("galaxyidx find -t " seek " starts at " seeked " s")
+    }
+
+    if (!failed) {
+        printf "check         %d words, %d frames, %d slots at %.1f us, block file matches\n",
+               words, good, slots, latency
+    }
+    exit failed
+}
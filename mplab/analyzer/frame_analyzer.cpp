@@ -0,0 +1,97 @@
+#include "app.h"
+#include "fifo.h"
+#include "uart.h"
+#include "galaxy.h"
+#include "timestamp.h"
+#include "frame_analyzer.h"
+
+namespace galaxy {
+
+FrameAnalyzer::FrameAnalyzer(double binUs, size_t bins, double windowUs)
+    : binUs_(binUs), bins_(bins), windowTicks_(uint64_t(windowUs * TIMESTAMP_TICKS_PER_US)) {
+    GalaxyDecoderInitialize(&decoder_);
+    // Opcode from the firmware's own table, the payload is the slot
+    pollOpcode_ = galaxyCommands[GALAXY_CMD_POLL_SLOT].words[2];
+}
+
+void FrameAnalyzer::OnWords(const CaptureWord* words, size_t count) {
+    if (stats_.words == 0) {
+        stats_.firstStamp = words[0].stamp;
+    }
+    stats_.lastStamp = words[count - 1].stamp;
+    stats_.words += count;
+
+    for (size_t i = 0; i < count; i++) {
+        unsigned int word = words[i].word;
+
+        if (word & GALAXY_FAULT_MASK) {
+            stats_.framingErrors += (word & UART_FAULT_FRAMING_ERROR) != 0;
+            stats_.overruns += (word & UART_FAULT_OVERRUN_ERROR) != 0;
+            stats_.noData += (word & UART_FAULT_NO_DATA_AVAILABLE) != 0;
+        } else if (word & GALAXY_ADDRESS_FLAG) {
+            stats_.addressWords++;
+        }
+
+        switch (GalaxyDecode(&decoder_, word, words[i].stamp)) {
+            case GALAXY_DECODE_FRAME:
+                Frame(GalaxyFramePeek(&decoder_));
+                GalaxyFrameRelease(&decoder_);
+                break;
+            case GALAXY_DECODE_CRC_ERROR:
+                stats_.crcErrors++;
+                break;
+            case GALAXY_DECODE_LENGTH_ERROR:
+                stats_.lengthErrors++;
+                break;
+            case GALAXY_DECODE_FAULT:
+                stats_.faults++;
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+// Words are missing, so cut any frame in progress and forget the poll
+void FrameAnalyzer::OnGap(unsigned int packets) {
+    (void)packets;
+    if (GalaxyDecode(&decoder_, UART_FAULT_NO_DATA_AVAILABLE, stats_.lastStamp) == GALAXY_DECODE_FAULT) {
+        stats_.gapCuts++;
+    }
+    pollPending_ = false;
+}
+
+void FrameAnalyzer::Frame(galaxyBuffer* frame) {
+    bool poll = frame->word_count >= 4 &&
+                GalaxyBufferGet(frame, 0) == GALAXY_BROADCAST_ADDRESS &&
+                frame->buffer[2] == pollOpcode_;
+
+    stats_.frames++;
+    stats_.addressFrames[frame->buffer[0]]++;
+
+    if (pollPending_) {
+        SlotStats& slot = slots_[pollSlot_];
+        uint64_t latency = frame->timestamp - pollEnd_;
+
+        if (poll || latency > windowTicks_) {
+            slot.timeouts++;
+        } else {
+            slot.responses++;
+            slot.latency->Add(double(latency) / TIMESTAMP_TICKS_PER_US);
+        }
+        pollPending_ = false;
+    }
+
+    if (poll) {
+        SlotStats& slot = slots_[frame->buffer[3]];
+        if (!slot.latency) {
+            slot.latency.reset(new Histogram(binUs_, bins_));
+        }
+        slot.polls++;
+        pollSlot_ = frame->buffer[3];
+        pollEnd_ = frame->end_timestamp;
+        pollPending_ = true;
+    }
+}
+
+}  // namespace galaxy
@@ -0,0 +1,73 @@
+/*
+ * File:   frame_analyzer.h
+ *
+ * Runs captured words through the firmware's own streaming decoder
+ * (galaxy.c) and keeps error counts, frames per address and per-slot poll
+ * response latencies. A response is the first good frame after a
+ * POLL_SLOT that is not itself a poll, as in poll.c, measured from the
+ * poll's last word to the response's first.
+ */
+
+#ifndef FRAME_ANALYZER_H
+#define	FRAME_ANALYZER_H
+
+#include <cstdint>
+#include <memory>
+#include "app.h"
+#include "galaxy.h"
+#include "capture_parser.h"
+#include "histogram.h"
+
+namespace galaxy {
+
+struct FrameStats {
+    uint64_t words = 0;
+    uint64_t addressWords = 0;
+    uint64_t framingErrors = 0;
+    uint64_t overruns = 0;
+    uint64_t noData = 0;
+    uint64_t frames = 0;
+    uint64_t crcErrors = 0;
+    uint64_t lengthErrors = 0;
+    uint64_t faults = 0;                    // UART fault inside a frame
+    uint64_t gapCuts = 0;                   // Frames cut by lost capture packets
+    uint64_t addressFrames[256] = {};
+    uint64_t firstStamp = 0;
+    uint64_t lastStamp = 0;
+};
+
+struct SlotStats {
+    uint64_t polls = 0;
+    uint64_t responses = 0;
+    uint64_t timeouts = 0;
+    std::unique_ptr<Histogram> latency;     // Microseconds
+};
+
+class FrameAnalyzer : public CaptureListener {
+public:
+    FrameAnalyzer(double binUs, size_t bins, double windowUs);
+
+    void OnWords(const CaptureWord* words, size_t count) override;
+    void OnGap(unsigned int packets) override;
+
+    const FrameStats& Stats() const { return stats_; }
+    const SlotStats& Slot(unsigned int slot) const { return slots_[slot]; }
+
+private:
+    void Frame(galaxyBuffer* frame);
+
+    galaxyDecoder decoder_;
+    FrameStats stats_;
+    SlotStats slots_[256];
+    double binUs_;
+    size_t bins_;
+    uint64_t windowTicks_;
+    bool pollPending_ = false;
+    unsigned int pollSlot_ = 0;
+    uint64_t pollEnd_ = 0;
+    unsigned char pollOpcode_;
+};
+
+}  // namespace galaxy
+
+#endif	/* FRAME_ANALYZER_H */
@@ -0,0 +1,175 @@
+/*
+ * File:   galaxyan.cpp
+ *
+ * Decodes a capture logged from the debugger's host port and reports link
+ * and bus errors, frames per address and poll response latency per slot.
+ *
+ *   galaxyan [-b bin_us] [-n bins] [-W window_us] [-a] [-H] [file]
+ *
+ * The file is the raw UART2 byte stream, for example from
+ * 'cat /dev/ttyUSB0 > capture.bin' or galaxysim -o. Without a file, or
+ * with "-", stdin is read. A block file written by galaxyidx is read
+ * block by block instead.
+ *
+ * -b and -n set the latency histogram bins, -W the longest gap after a
+ * poll still counted as its response. -a lists frames per address and -H
+ * prints each slot's histogram.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+#include "app.h"
+#include "galaxy.h"
+#include "tick.h"
+#include "poll.h"
+#include "timestamp.h"
+#include "capture_parser.h"
+#include "capture_input.h"
+#include "capture_blocks.h"
+#include "frame_analyzer.h"
+
+using namespace galaxy;
+
+static void Usage() {
+    fprintf(stderr, "usage: galaxyan [-b bin_us] [-n bins] [-W window_us] [-a] [-H] [file]\n");
+    exit(2);
+}
+
+// Feeds a block file to the analyzer as if it came from a CaptureParser
+static bool AnalyzeBlockFile(const std::string& path, FrameAnalyzer& analyzer, std::string& error) {
+    BlockFile file;
+    std::vector<CaptureWord> words;
+
+    if (!file.Open(path, error)) {
+        return false;
+    }
+    for (uint64_t b = 0; b < file.Blocks(); b++) {
+        if (!file.ReadBlock(b, words, error)) {
+            return false;
+        }
+        if (file.Entry(b).flags & BLOCK_FLAG_GAP) {
+            analyzer.OnGap(1);
+        }
+        analyzer.OnWords(words.data(), words.size());
+    }
+    return true;
+}
+
+static void PrintHistogram(const Histogram& h) {
+    const std::vector<uint64_t>& bins = h.Bins();
+    uint64_t peak = 0;
+
+    for (uint64_t count : bins) {
+        peak = count > peak ? count : peak;
+    }
+    for (size_t bin = 0; bin < bins.size(); bin++) {
+        if (bins[bin] == 0) {
+            continue;
+        }
+        int bar = int(40 * bins[bin] / peak);
+        if (bin == bins.size() - 1) {
+            printf("      >= %7.0f us %10llu %.*s\n", bin * h.BinWidth(),
+                   (unsigned long long)bins[bin], bar, "########################################");
+        } else {
+            printf("    %7.0f-%-7.0f us %8llu %.*s\n", bin * h.BinWidth(), (bin + 1) * h.BinWidth(),
+                   (unsigned long long)bins[bin], bar, "########################################");
+        }
+    }
+}
+
+int main(int argc, char** argv) {
+    double binUs = 50;
+    size_t bins = 40;
+    double windowUs = POLL_WINDOW_TICKS_DEFAULT * (double)TICK_PERIOD_US;
+    bool addresses = false;
+    bool histograms = false;
+    std::string path = "-";
+    std::string error;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "b:n:W:aH")) != -1) {
+        switch (opt) {
+            case 'b': binUs = atof(optarg); break;
+            case 'n': bins = strtoul(optarg, nullptr, 10); break;
+            case 'W': windowUs = atof(optarg); break;
+            case 'a': addresses = true; break;
+            case 'H': histograms = true; break;
+            default: Usage();
+        }
+    }
+    if (binUs <= 0 || bins == 0 || argc - optind > 1) {
+        Usage();
+    }
+    if (optind < argc) {
+        path = argv[optind];
+    }
+
+    FrameAnalyzer analyzer(binUs, bins, windowUs);
+    CaptureParser parser(analyzer);
+    auto start = std::chrono::steady_clock::now();
+    bool blocks = path != "-" && BlockFile::IsBlockFile(path);
+    if (blocks ? !AnalyzeBlockFile(path, analyzer, error) : !ParseCaptureFile(path, parser, error)) {
+        fprintf(stderr, "galaxyan: %s\n", error.c_str());
+        return 2;
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    const CaptureLinkStats& link = parser.Stats();
+    const FrameStats& bus = analyzer.Stats();
+    double span = double(bus.lastStamp - bus.firstStamp) / TIMESTAMP_TICKS_PER_US / 1e6;
+
+    if (blocks) {
+        // Host link counters were not kept, the index only marks gaps
+        printf("capture       block file, %.3f s of bus time, decoded in %.3f s, %.1f M words/s\n",
+               span, elapsed, elapsed > 0 ? bus.words / elapsed / 1e6 : 0.0);
+    } else {
+        printf("capture       %llu bytes, %.3f s of bus time, decoded in %.3f s, %.1f M words/s\n",
+               (unsigned long long)link.bytes, span, elapsed, elapsed > 0 ? bus.words / elapsed / 1e6 : 0.0);
+        printf("host link     %llu packets, %llu capture, %llu other, %llu CRC errors, %llu bytes skipped\n",
+               (unsigned long long)link.packets, (unsigned long long)link.capturePackets,
+               (unsigned long long)link.otherPackets, (unsigned long long)link.crcErrors,
+               (unsigned long long)link.skippedBytes);
+        printf("              %llu capture packets lost, %llu malformed, %llu bytes truncated\n",
+               (unsigned long long)link.sequenceGaps, (unsigned long long)link.malformed,
+               (unsigned long long)link.truncated);
+    }
+    printf("words         %llu, %llu addresses, %llu framing errors, %llu overruns, %llu no data\n",
+           (unsigned long long)bus.words, (unsigned long long)bus.addressWords,
+           (unsigned long long)bus.framingErrors, (unsigned long long)bus.overruns,
+           (unsigned long long)bus.noData);
+    printf("frames        %llu good, %llu CRC errors, %llu length errors, %llu faults, %llu cut by lost packets\n",
+           (unsigned long long)bus.frames, (unsigned long long)bus.crcErrors,
+           (unsigned long long)bus.lengthErrors, (unsigned long long)bus.faults,
+           (unsigned long long)bus.gapCuts);
+
+    if (addresses) {
+        for (unsigned int a = 0; a < 256; a++) {
+            if (bus.addressFrames[a]) {
+                printf("address %02X    %llu frames\n", a, (unsigned long long)bus.addressFrames[a]);
+            }
+        }
+    }
+
+    for (unsigned int s = 0; s < 256; s++) {
+        const SlotStats& slot = analyzer.Slot(s);
+        if (slot.polls == 0) {
+            continue;
+        }
+        const Histogram& h = *slot.latency;
+        printf("slot %-3u      %llu polls, %llu responses, %llu timeouts", s,
+               (unsigned long long)slot.polls, (unsigned long long)slot.responses,
+               (unsigned long long)slot.timeouts);
+        if (h.Count()) {
+            printf(", latency us min %.1f mean %.1f p50 %.0f p99 %.0f max %.1f",
+                   h.Min(), h.Mean(), h.Percentile(0.50), h.Percentile(0.99), h.Max());
+        }
+        printf("\n");
+        if (histograms && h.Count()) {
+            PrintHistogram(h);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,223 @@
+/*
+ * File:   galaxyidx.cpp
+ *
+ * Writes and searches block capture files (capture_blocks.h).
+ *
+ *   galaxyidx write [-z level] [-w words] capture.bin out.gcb
+ *   galaxyidx info out.gcb
+ *   galaxyidx find [-t seconds] [-a address] [-e] [-n count] out.gcb
+ *
+ * write converts a host port log, -z 1-9 deflates each block. find starts
+ * at -t seconds into the recording and prints the next -n (default 10)
+ * frames from -a address, or with -e the next errors. The index rules out
+ * blocks without a match, only the rest are read and decoded.
+ */
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <unistd.h>
+#include "app.h"
+#include "fifo.h"
+#include "uart.h"
+#include "galaxy.h"
+#include "capture_parser.h"
+#include "capture_input.h"
+#include "capture_blocks.h"
+
+using namespace galaxy;
+
+static void Usage() {
+    fprintf(stderr, "usage: galaxyidx write [-z level] [-w words] capture.bin out.gcb\n"
+                    "       galaxyidx info out.gcb\n"
+                    "       galaxyidx find [-t seconds] [-a address] [-e] [-n count] out.gcb\n");
+    exit(2);
+}
+
+static int Write(int argc, char** argv) {
+    int level = 0;
+    uint32_t blockWords = BLOCK_WORDS_DEFAULT;
+    std::string error;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "z:w:")) != -1) {
+        switch (opt) {
+            case 'z': level = atoi(optarg); break;
+            case 'w': blockWords = strtoul(optarg, nullptr, 10); break;
+            default: Usage();
+        }
+    }
+    if (argc - optind != 2 || level < 0 || level > 9 || blockWords == 0) {
+        Usage();
+    }
+
+    BlockWriter writer;
+    CaptureParser parser(writer);
+    if (!writer.Open(argv[optind + 1], blockWords, level, error) ||
+            !ParseCaptureFile(argv[optind], parser, error) ||
+            !writer.Close(error)) {
+        fprintf(stderr, "galaxyidx: %s\n", error.c_str());
+        return 2;
+    }
+    printf("%llu words in %llu blocks, %llu bytes of records stored in %llu\n",
+           (unsigned long long)writer.Words(), (unsigned long long)writer.Blocks(),
+           (unsigned long long)writer.RawBytes(), (unsigned long long)writer.StoredBytes());
+    return 0;
+}
+
+static int Info(int argc, char** argv) {
+    BlockFile file;
+    std::string error;
+    uint64_t words = 0;
+    uint64_t flagged[6] = {};
+    static const char* names[6] = { "CRC", "length", "fault", "framing", "overrun", "gap" };
+
+    if (argc != 2) {
+        Usage();
+    }
+    if (!file.Open(argv[1], error)) {
+        fprintf(stderr, "galaxyidx: %s\n", error.c_str());
+        return 2;
+    }
+    for (uint64_t b = 0; b < file.Blocks(); b++) {
+        BlockIndexEntry entry = file.Entry(b);
+        words += entry.words;
+        for (int f = 0; f < 6; f++) {
+            flagged[f] += (entry.flags >> f) & 1;
+        }
+    }
+    printf("%llu words in %llu blocks", (unsigned long long)words, (unsigned long long)file.Blocks());
+    if (file.Blocks()) {
+        double span = (file.Entry(file.Blocks() - 1).lastStamp - file.Entry(0).firstStamp) / file.TicksPerUs() / 1e6;
+        printf(", %.3f s", span);
+    }
+    printf("\nblocks with");
+    for (int f = 0; f < 6; f++) {
+        printf(" %s %llu%s", names[f], (unsigned long long)flagged[f], f < 5 ? "," : "\n");
+    }
+    return 0;
+}
+
+static void PrintFrame(double seconds, galaxyBuffer* frame) {
+    printf("%14.6f s  frame  ", seconds);
+    for (unsigned char i = 0; i < frame->word_count; i++) {
+        printf(" %03X", GalaxyBufferGet(frame, i));
+    }
+    printf(" crc %04X\n", frame->crc);
+}
+
+static int Find(int argc, char** argv) {
+    double seconds = 0;
+    int address = -1;
+    bool errors = false;
+    unsigned long limit = 10;
+    unsigned long found = 0;
+    uint64_t decoded = 0;
+    std::vector<CaptureWord> words;
+    BlockFile file;
+    std::string error;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:a:en:")) != -1) {
+        switch (opt) {
+            case 't': seconds = atof(optarg); break;
+            case 'a': address = int(strtoul(optarg, nullptr, 16) & 0xFF); break;
+            case 'e': errors = true; break;
+            case 'n': limit = strtoul(optarg, nullptr, 10); break;
+            default: Usage();
+        }
+    }
+    if (argc - optind != 1 || (address < 0 && !errors)) {
+        Usage();
+    }
+    if (!file.Open(argv[optind], error)) {
+        fprintf(stderr, "galaxyidx: %s\n", error.c_str());
+        return 2;
+    }
+    if (file.Blocks() == 0) {
+        return 0;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    uint64_t origin = file.Entry(0).firstStamp;
+    uint64_t from = origin + uint64_t(seconds * 1e6 * file.TicksPerUs());
+    uint64_t b = file.FindStamp(from);
+
+    for (; b < file.Blocks() && found < limit; b++) {
+        BlockIndexEntry entry = file.Entry(b);
+        if (!((errors && (entry.flags & BLOCK_FLAG_ERRORS)) || (address >= 0 && entry.HasAddress(address)))) {
+            continue;
+        }
+        if (!file.ReadBlock(b, words, error)) {
+            fprintf(stderr, "galaxyidx: %s\n", error.c_str());
+            return 2;
+        }
+        decoded++;
+
+        galaxyDecoder decoder;
+        GalaxyDecoderInitialize(&decoder);
+        int owner = -1;     // Address of the frame being decoded
+        if (errors && (entry.flags & BLOCK_FLAG_GAP) && entry.firstStamp >= from) {
+            printf("%14.6f s  capture packets lost before block %llu\n",
+                   (entry.firstStamp - origin) / file.TicksPerUs() / 1e6, (unsigned long long)b);
+            found++;
+        }
+        for (size_t i = 0; i < words.size() && found < limit; i++) {
+            const CaptureWord& w = words[i];
+            double at = (w.stamp - origin) / file.TicksPerUs() / 1e6;
+            int previous = owner;
+            if ((w.word & GALAXY_ADDRESS_FLAG) && !(w.word & GALAXY_FAULT_MASK)) {
+                owner = w.word & 0xFF;
+            }
+            unsigned char result = GalaxyDecode(&decoder, w.word, w.stamp);
+            bool after = w.stamp >= from;
+
+            if (errors && after && (w.word & GALAXY_FAULT_MASK)) {
+                printf("%14.6f s  word %03X%s%s%s\n", at, w.word & 0x1FF,
+                       (w.word & UART_FAULT_FRAMING_ERROR) ? " framing error" : "",
+                       (w.word & UART_FAULT_OVERRUN_ERROR) ? " overrun" : "",
+                       (w.word & UART_FAULT_NO_DATA_AVAILABLE) ? " no data" : "");
+                found++;
+            }
+            if (errors && after && (result == GALAXY_DECODE_CRC_ERROR || result == GALAXY_DECODE_LENGTH_ERROR)) {
+                // An address word ends the frame before it with a length error
+                printf("%14.6f s  %s error in frame from %02X\n", at,
+                       result == GALAXY_DECODE_CRC_ERROR ? "CRC" : "length", previous & 0xFF);
+                found++;
+            }
+            if (result == GALAXY_DECODE_FRAME) {
+                galaxyBuffer* frame = GalaxyFramePeek(&decoder);
+                if (address >= 0 && after && frame->buffer[0] == address && found < limit) {
+                    PrintFrame((frame->timestamp - origin) / file.TicksPerUs() / 1e6, frame);
+                    found++;
+                }
+                GalaxyFrameRelease(&decoder);
+            }
+        }
+    }
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    fprintf(stderr, "%lu found, %llu of %llu blocks decoded, %.2f ms\n", found,
+            (unsigned long long)decoded, (unsigned long long)file.Blocks(), elapsed * 1e3);
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        Usage();
+    }
+    // Subcommand options start after the subcommand
+    if (strcmp(argv[1], "write") == 0) {
+        return Write(argc - 1, argv + 1);
+    }
+    if (strcmp(argv[1], "info") == 0) {
+        return Info(argc - 1, argv + 1);
+    }
+    if (strcmp(argv[1], "find") == 0) {
+        return Find(argc - 1, argv + 1);
+    }
+    Usage();
+}
@@ -0,0 +1,67 @@
+/*
+ * File:   histogram.h
+ *
+ * Fixed-width bin histogram with an overflow bin, for latencies in
+ * microseconds.
+ */
+
+#ifndef HISTOGRAM_H
+#define	HISTOGRAM_H
+
+#include <cstdint>
+#include <vector>
+
+namespace galaxy {
+
+class Histogram {
+public:
+    Histogram(double binWidth, size_t bins) : width_(binWidth), counts_(bins + 1, 0) {}
+
+    void Add(double value) {
+        size_t bin = value < 0 ? 0 : size_t(value / width_);
+        if (bin >= counts_.size() - 1) {
+            bin = counts_.size() - 1;
+        }
+        counts_[bin]++;
+        if (count_ == 0 || value < min_) {
+            min_ = value;
+        }
+        if (count_ == 0 || value > max_) {
+            max_ = value;
+        }
+        sum_ += value;
+        count_++;
+    }
+
+    // Upper edge of the bin holding the given fraction, capped at the maximum
+    double Percentile(double fraction) const {
+        uint64_t target = uint64_t(fraction * count_);
+        uint64_t seen = 0;
+        for (size_t bin = 0; bin < counts_.size() - 1; bin++) {
+            seen += counts_[bin];
+            if (seen > target) {
+                return (bin + 1) * width_ < max_ ? (bin + 1) * width_ : max_;
+            }
+        }
+        return max_;
+    }
+
+    uint64_t Count() const { return count_; }
+    double Min() const { return min_; }
+    double Max() const { return max_; }
+    double Mean() const { return count_ ? sum_ / count_ : 0; }
+    double BinWidth() const { return width_; }
+    const std::vector<uint64_t>& Bins() const { return counts_; }   // Last is overflow
+
+private:
+    double width_;
+    std::vector<uint64_t> counts_;
+    uint64_t count_ = 0;
+    double min_ = 0;
+    double max_ = 0;
+    double sum_ = 0;
+};
+
+}  // namespace galaxy
+
+#endif	/* HISTOGRAM_H */
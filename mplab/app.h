@@ -15,7 +15,10 @@ extern "C" {
 #define _XTAL_FREQ 64000000
 
 #define FIFO_COUNT 4
-#define FIFO_SIZE 32
+#define FIFO_SIZE 128
+#ifndef FIFO_UNPACKED_STORAGE           // -D for the bench comparison
+#define FIFO_PACKED_STORAGE             // 12-bit words in 1.5 bytes instead of 2
+#endif
 #define HOST_RX_FIFO        0
 #define DEVICE_TX_FIFO      1
 #define DEVICE_RX_FIFO      2
@@ -24,13 +27,24 @@ extern "C" {
 #define TRUE 1
 #define FALSE 0
 
-#define DIGITAL_OUT_WORD_COUNT 3
+#define POLL_AT_STARTUP FALSE           // Act as bus master from power up
+#define CAPTURE_AT_STARTUP TRUE         // Stream received words to the host
+#ifndef PROFILE_ENABLED
+#define PROFILE_ENABLED FALSE           // Time the ISRs and tasks, see profile.h
+#endif
+#define PROFILE_PIN FALSE               // With PROFILE_ENABLED, DIG_OUT_14 high in the ISRs
     
+void AppInitialize(void);
+void AppService(void);
 void TinyDelay();
+unsigned char QueueDeviceCommand(unsigned char command);
+void DigitalBreakoutInitialize(void);
 void DigitalBreakout(unsigned int newData);
 unsigned long ToAscii(unsigned long in);
 unsigned char NibbleToAscii(unsigned char in);
 
+extern volatile unsigned int rxOverrunsAvoided;
+
 
 // LED PINS
 #define PIN_LED_RED_TRIS            TRISAbits.TRISA6
@@ -40,8 +54,23 @@ unsigned char NibbleToAscii(unsigned char in);
 #define PIN_LED_BLUE_TRIS           TRISBbits.TRISB5
 #define PIN_LED_BLUE_LATCH          LATBbits.LATB5
 
+// LED timing in system ticks
+#define LED_BLINK_TICKS             256     // Blue heartbeat, each half period
+#define LED_RX_TICKS                50      // Green after a received word
+#define LED_TX_TICKS                25      // Red after a queued command
+
 
 // DIGITAL BREAKOUT PINS
+// Word bit n drives DIG_OUT_n for bits 0..11, trigger pins are 12..14
+#define DIG_OUT_PORTA_MASK          0x0F    // DIG_OUT_0..3 on RA0..RA3
+#define DIG_OUT_PORTC_MASK          0x3F    // DIG_OUT_4..9 on RC0..RC5
+#if PROFILE_ENABLED && PROFILE_PIN
+#define DIG_OUT_PORTB_MASK          0x0F    // DIG_OUT_10..13 on RB0..RB3
+#else
+#define DIG_OUT_PORTB_MASK          0x1F    // DIG_OUT_10..14 on RB0..RB4
+#endif
+#define DIG_OUT_TRIGGER_SHIFT       2       // DIG_OUT_12 is RB2
+
 #define PIN_DIG_OUT_14_TRIS         TRISBbits.TRISB4
 #define PIN_DIG_OUT_14_LATCH        LATBbits.LATB4
 #define PIN_DIG_OUT_13_TRIS         TRISBbits.TRISB3
@@ -0,0 +1,215 @@
+#include <xc.h>
+#include "app.h"
+#include "fifo.h"
+#include "uart.h"
+#include "galaxy.h"
+#include "host.h"
+#include "capture.h"
+#include "poll.h"
+#include "replay.h"
+#include "busconfig.h"
+#include "bridge.h"
+
+// Host byte decoder states
+#define BRIDGE_HOST_DATA            0
+#define BRIDGE_HOST_ESCAPED         1
+#define BRIDGE_HOST_ADDRESS         2
+
+volatile unsigned int bridgeHostDropped = 0;
+volatile unsigned int bridgeDeviceDropped = 0;
+
+// HighIsr produces HOST_TX_FIFO while bridgeTx is set, main() otherwise.
+// LowIsr produces DEVICE_TX_FIFO while bridgeRx is set.
+static volatile unsigned char bridgeTx = FALSE;
+static volatile unsigned char bridgeRx = FALSE;
+static volatile unsigned char bridgeExit = FALSE;   // EXIT seen, main() finishes it
+static unsigned char bridgeStarting = FALSE;
+static unsigned char bridgeCapture = FALSE;         // Capture state to restore
+static unsigned char bridgeHostState = BRIDGE_HOST_DATA;
+static unsigned char bridgeSent = 0;                // Words on the bus not yet credited
+
+void BridgeInitialize(void) {
+    bridgeTx = FALSE;
+    bridgeRx = FALSE;
+    bridgeExit = FALSE;
+    bridgeStarting = FALSE;
+    bridgeHostDropped = 0;
+    bridgeDeviceDropped = 0;
+}
+
+// TRUE while main() must leave HOST_TX_FIFO alone
+unsigned char BridgeActive(void) {
+    return bridgeTx || bridgeExit;
+}
+
+// Work for BridgeService
+unsigned char BridgePending(void) {
+    return bridgeStarting || bridgeExit ||
+           (bridgeTx && !IsFifoEmpty(&buffers[HOST_TX_FIFO]) && !PIE3bits.TX2IE);
+}
+
+//===============================================================================
+//	Description:	Switches UART2 over once the acknowledge for
+//					HOST_COMMAND_BRIDGE is queued, and back after the host
+//					sent BRIDGE_CODE_EXIT. Call from the main loop straight
+//					after HostService, before anything else can queue a
+//					packet behind the acknowledge.
+//
+//	Params:			NONE
+//
+//	Returns:			NONE
+//===============================================================================
+void BridgeService(void) {
+    buffer16* fifo = &buffers[HOST_TX_FIFO];
+
+    if (bridgeStarting) {
+        bridgeStarting = FALSE;
+        bridgeHostState = BRIDGE_HOST_DATA;
+        bridgeSent = 0;
+        bridgeTx = TRUE;
+        bridgeRx = TRUE;
+    }
+    if (bridgeExit) {
+        bridgeTx = FALSE;
+        if (FIFO_SIZE - FifoCount(fifo) < 2) {
+            return;                         // Marker goes out on a later pass
+        }
+        FifoEnqueue(fifo, BRIDGE_ESCAPE);
+        FifoEnqueue(fifo, BRIDGE_CODE_EXIT);
+        UART_StartTransmit(HOST_UART_INDEX);
+        bridgeExit = FALSE;
+        CaptureEnable(bridgeCapture);
+    }
+    // LowIsr masks TX2IE when it finds the FIFO empty, and HighIsr can
+    // queue bytes between the check and the mask
+    if (bridgeTx && !IsFifoEmpty(fifo) && !PIE3bits.TX2IE) {
+        UART_StartTransmit(HOST_UART_INDEX);
+    }
+}
+
+// Empty payload. Capture is flushed here so its last packet goes out
+// before the acknowledge.
+unsigned char BridgeHostCommand(const unsigned char* payload, unsigned char length) {
+    (void)payload;
+
+    if (length != 0) {
+        return BRIDGE_ERROR_FORMAT;
+    }
+    if (BusConfigDetecting()) {
+        return BRIDGE_ERROR_STATE;
+    }
+    if (!IsFifoEmpty(&buffers[DEVICE_TX_FIFO])) {
+        return BRIDGE_ERROR_BUSY;
+    }
+    // The host is the bus master now
+    PollStop();
+    ReplayStop();
+    bridgeCapture = CaptureActive();
+    CaptureEnable(FALSE);
+    bridgeStarting = TRUE;
+    return HOST_STATUS_OK;
+}
+
+//===============================================================================
+//	Description:	RC2IF handler while bridging. Unescapes one host byte and
+//					queues a completed word for UART1.
+//
+//	Params:			DATA			UINT		GetChar9 result
+//
+//	Returns:			FALSE when not bridging, the byte is for HOST_RX_FIFO
+//===============================================================================
+unsigned char BridgeHostInterrupt(unsigned int data) {
+    unsigned int word;
+
+    if (!bridgeRx) {
+        return FALSE;
+    }
+    if (data & GALAXY_FAULT_MASK) {
+        bridgeHostState = BRIDGE_HOST_DATA;
+        return TRUE;
+    }
+    data &= 0xFF;
+    if (bridgeHostState == BRIDGE_HOST_ESCAPED) {
+        bridgeHostState = BRIDGE_HOST_DATA;
+        if (data == BRIDGE_CODE_ADDRESS) {
+            bridgeHostState = BRIDGE_HOST_ADDRESS;
+            return TRUE;
+        }
+        if (data == BRIDGE_CODE_EXIT) {
+            bridgeRx = FALSE;
+            bridgeExit = TRUE;
+            return TRUE;
+        }
+        if (data != BRIDGE_CODE_ESCAPE) {
+            return TRUE;
+        }
+        word = BRIDGE_ESCAPE;
+    } else if (bridgeHostState == BRIDGE_HOST_ADDRESS) {
+        bridgeHostState = BRIDGE_HOST_DATA;
+        word = GALAXY_ADDRESS_FLAG | data;
+    } else if (data == BRIDGE_ESCAPE) {
+        bridgeHostState = BRIDGE_HOST_ESCAPED;
+        return TRUE;
+    } else {
+        word = data;
+    }
+
+    if (!FifoEnqueue(&buffers[DEVICE_TX_FIFO], word)) {
+        bridgeHostDropped++;
+    }
+    // Returns at once, Timer4 times the driver turnaround
+    UART_StartTransmit(UART1_INDEX);
+    return TRUE;
+}
+
+//===============================================================================
+//	Description:	RC1IF handler hook. Escapes a received bus word into
+//					HOST_TX_FIFO, or drops it whole if there is no room.
+//
+//	Params:			DATA			UINT		GetChar9 result
+//
+//	Returns:			NONE
+//===============================================================================
+void BridgeDeviceInterrupt(unsigned int data) {
+    buffer16* fifo = &buffers[HOST_TX_FIFO];
+    unsigned char low = (unsigned char)data;
+
+    if (!bridgeTx) {
+        return;
+    }
+    if (FIFO_SIZE - FifoCount(fifo) < BRIDGE_WORD_MAX_SIZE) {
+        bridgeDeviceDropped++;
+        return;
+    }
+    if (data & GALAXY_FAULT_MASK) {
+        FifoEnqueue(fifo, BRIDGE_ESCAPE);
+        FifoEnqueue(fifo, BRIDGE_CODE_FAULT);
+        FifoEnqueue(fifo, (data >> 8) & 0x0F);
+    } else if (data & GALAXY_ADDRESS_FLAG) {
+        FifoEnqueue(fifo, BRIDGE_ESCAPE);
+        FifoEnqueue(fifo, BRIDGE_CODE_ADDRESS);
+    } else if (low == BRIDGE_ESCAPE) {
+        FifoEnqueue(fifo, BRIDGE_ESCAPE);
+        low = BRIDGE_CODE_ESCAPE;
+    }
+    FifoEnqueue(fifo, low);
+    UART_StartTransmit(HOST_UART_INDEX);
+}
+
+// TX1IF hook, ahead of UART_TransmitInterrupt. Counts the word about to
+// be loaded and hands the host a credit every BRIDGE_CREDIT_BATCH.
+void BridgeTransmitInterrupt(void) {
+    buffer16* fifo = &buffers[HOST_TX_FIFO];
+
+    if (!bridgeTx || IsFifoEmpty(&buffers[DEVICE_TX_FIFO])) {
+        return;
+    }
+    if (++bridgeSent < BRIDGE_CREDIT_BATCH || FIFO_SIZE - FifoCount(fifo) < 3) {
+        return;
+    }
+    FifoEnqueue(fifo, BRIDGE_ESCAPE);
+    FifoEnqueue(fifo, BRIDGE_CODE_CREDIT);
+    FifoEnqueue(fifo, bridgeSent);
+    bridgeSent = 0;
+    UART_StartTransmit(HOST_UART_INDEX);
+}
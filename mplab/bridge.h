@@ -0,0 +1,77 @@
+/*
+ * File:   bridge.h
+ *
+ * Transparent bridge between the host link and the Galaxy bus, so a PC
+ * tool can be bus master through this board. HOST_COMMAND_BRIDGE (empty
+ * payload) is acknowledged as usual, after which UART2 carries a byte
+ * stream instead of packets until the host sends BRIDGE_CODE_EXIT. The
+ * host must wait for the acknowledge before streaming.
+ *
+ * Words are forwarded from the receive interrupts: UART2 bytes go straight
+ * into DEVICE_TX_FIFO and UART1 words into HOST_TX_FIFO, so a word is on
+ * its way out a few microseconds after its last byte arrives. UART1 words
+ * still reach DEVICE_RX_FIFO for the decoder, stats and triggers; capture
+ * packets are paused. The line echo means the host sees its own words too.
+ * The address filter only applies to capture, except that FILTER_MODE_
+ * HARDWARE keeps rejected frames out of the UART and so out of the bridge.
+ *
+ * A 9 bit word has no 8 bit form, so both directions escape:
+ *
+ *     byte                data word, not BRIDGE_ESCAPE
+ *     ESC, ADDRESS, b     address word 0x100 | b
+ *     ESC, ESCAPE         data word BRIDGE_ESCAPE
+ *     ESC, FAULT, f, b    device to host: word b with bits 8-11 f, received
+ *                         with a UART fault
+ *     ESC, CREDIT, n      device to host: n more words may be sent
+ *     ESC, EXIT           host: leave the bridge; device: left, packets
+ *                         follow
+ *
+ * The host starts with BRIDGE_CREDIT_INITIAL words of credit and gets
+ * BRIDGE_CREDIT_BATCH back each time that many have gone out on the bus.
+ */
+
+#ifndef BRIDGE_H
+#define	BRIDGE_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#define BRIDGE_ESCAPE               0x7D
+
+// Byte after BRIDGE_ESCAPE
+#define BRIDGE_CODE_ADDRESS         0x01
+#define BRIDGE_CODE_ESCAPE          0x02
+#define BRIDGE_CODE_FAULT           0x03
+#define BRIDGE_CODE_CREDIT          0x04
+#define BRIDGE_CODE_EXIT            0x05
+
+#define BRIDGE_CREDIT_INITIAL       FIFO_SIZE
+#define BRIDGE_CREDIT_BATCH         16
+#define BRIDGE_WORD_MAX_SIZE        4       // Longest escape, a fault word
+
+// Host command status codes
+#define BRIDGE_ERROR_FORMAT         1       // Payload not empty
+#define BRIDGE_ERROR_STATE          2       // Auto-baud running
+#define BRIDGE_ERROR_BUSY           3       // UART1 still transmitting
+
+extern volatile unsigned int bridgeHostDropped;      // Host words refused by DEVICE_TX_FIFO
+extern volatile unsigned int bridgeDeviceDropped;    // Bus words refused by HOST_TX_FIFO
+
+void BridgeInitialize(void);
+unsigned char BridgeActive(void);
+unsigned char BridgePending(void);
+void BridgeService(void);
+unsigned char BridgeHostCommand(const unsigned char* payload, unsigned char length);
+
+// Interrupt side, see main.c
+unsigned char BridgeHostInterrupt(unsigned int data);
+void BridgeDeviceInterrupt(unsigned int data);
+void BridgeTransmitInterrupt(void);
+
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* BRIDGE_H */
@@ -0,0 +1,242 @@
+#include <xc.h>
+#include "app.h"
+#include "fifo.h"
+#include "uart.h"
+#include "galaxy.h"
+#include "tick.h"
+#include "host.h"
+#include "poll.h"
+#include "replay.h"
+#include "busconfig.h"
+
+static unsigned char busBaudCode = BUS_BAUD_CODE_DEFAULT;
+static unsigned char busMode = BUS_MODE_DEFAULT;
+static unsigned char busState = BUS_STATE_SET;
+static unsigned int busCount = 0;               // Shortest ABD measurement
+static unsigned char busSamples = 0;
+static unsigned char busCandidate = 0;          // Rate being confirmed
+static unsigned char busConfirmed = 0;          // Clean words at that rate
+static unsigned int busStartTick = 0;
+static unsigned char busReportPending = FALSE;
+
+void BusConfigInitialize(void) {
+    busBaudCode = BUS_BAUD_CODE_DEFAULT;
+    busMode = BUS_MODE_DEFAULT;
+    busState = BUS_STATE_SET;
+    busCount = 0;
+    busReportPending = FALSE;
+    UART_Initialize(
+            UART1_INDEX,
+            busBaudCode,
+            busMode,
+            UART_INTERRUPTS_HIGH_PRI
+    );
+}
+
+unsigned char BusConfigDetecting(void) {
+    return busState == BUS_STATE_DETECTING;
+}
+
+// Work for BusConfigService
+unsigned char BusConfigPending(void) {
+    return busState == BUS_STATE_DETECTING || busReportPending;
+}
+
+// A rate change under a word in the shift register would garble it. The
+// poller and replay share the transmitter, so they are stopped.
+static unsigned char BusClaim(void) {
+    if (!IsFifoEmpty(&buffers[DEVICE_TX_FIFO]) || !UART_TransmitService(UART1_INDEX)) {
+        return FALSE;
+    }
+    PollStop();
+    ReplayStop();
+    return TRUE;
+}
+
+// Drops what arrived at the old rate and hands the receiver back to HighIsr
+static void BusReceiveResume(void) {
+    RCSTA1bits.CREN = 0;                    // Clears OERR
+    RCSTA1bits.CREN = 1;
+    while (PIR1bits.RC1IF) {
+        (void)RCREG1;
+    }
+    PIE1bits.RC1IE = 1;
+}
+
+static void BusAutoBaudArm(void) {
+    BAUDCON1bits.ABDOVF = 0;
+    BAUDCON1bits.ABDEN = 1;
+}
+
+static void BusAutoBaudFinish(unsigned char state) {
+    BAUDCON1bits.ABDEN = 0;
+    busState = state;
+    if (state == BUS_STATE_LOCKED) {
+        busBaudCode = busCandidate;
+    }
+    // ABD or a rejected candidate left its count in SPBRGH:SPBRG
+    UART_SetBaud(UART1_INDEX, busBaudCode);
+    BusReceiveResume();
+    busReportPending = TRUE;
+}
+
+// Next table rate, from FROM up, at which the shortest measurement spans
+// a plausible number of bit times. ABD counts 8 bit times as SPBRG + 1.
+static unsigned char BusAutoBaudCandidate(unsigned char from) {
+    for (unsigned char code=from; code < UART_BAUD_CODE_COUNT; code++) {
+        unsigned long table = uartSpbrg[code] + 1UL;
+        if ((unsigned long)busCount * 100 >= table * BUS_AUTOBAUD_LOW_PERCENT &&
+                (unsigned long)busCount * 100 <= table * BUS_AUTOBAUD_HIGH_PERCENT) {
+            return code;
+        }
+    }
+    return BUS_BAUD_AUTO;
+}
+
+// Receives at the next candidate rate, or finishes without a lock
+static void BusAutoBaudTry(unsigned char from) {
+    busCandidate = BusAutoBaudCandidate(from);
+    busConfirmed = 0;
+    if (busCandidate == BUS_BAUD_AUTO) {
+        BusAutoBaudFinish(BUS_STATE_NO_LOCK);
+        return;
+    }
+    UART_SetBaud(UART1_INDEX, busCandidate);
+    RCSTA1bits.CREN = 0;                    // Clears OERR
+    RCSTA1bits.CREN = 1;
+    while (PIR1bits.RC1IF) {
+        (void)RCREG1;
+    }
+}
+
+//===============================================================================
+//	Description:	Switches UART1 to a table rate and 8 or 9 bit mode
+//					without resetting the port, so ADDEN and the receive
+//					interrupt stay as they are. Cancels auto-baud.
+//
+//	Params:			BAUDCODE		UCHAR		UART_BAUD_CODE_ rate
+//					MODE			UCHAR		UART_8BIT_MODE or UART_9BIT_MODE
+//
+//	Returns:			HOST_STATUS_OK or a BUS_ERROR_ code
+//===============================================================================
+unsigned char BusConfigSet(unsigned char baudCode, unsigned char mode) {
+    if (baudCode >= UART_BAUD_CODE_COUNT || mode > UART_9BIT_MODE) {
+        return BUS_ERROR_FORMAT;
+    }
+    if (!BusClaim()) {
+        return BUS_ERROR_BUSY;
+    }
+    busBaudCode = baudCode;
+    busMode = mode;
+    busCount = 0;
+    UART_SetMode(UART1_INDEX, mode);
+    UART_SetBaud(UART1_INDEX, baudCode);
+    if (busState == BUS_STATE_DETECTING) {
+        BAUDCON1bits.ABDEN = 0;
+        BusReceiveResume();
+    }
+    busState = BUS_STATE_SET;
+    return HOST_STATUS_OK;
+}
+
+//===============================================================================
+//	Description:	Starts measuring the bus rate. The receive interrupt is
+//					masked until BusConfigService has confirmed a rate or
+//					gives up after BUS_AUTOBAUD_TIMEOUT_TICKS.
+//
+//	Params:			MODE			UCHAR		UART_8BIT_MODE or UART_9BIT_MODE
+//
+//	Returns:			HOST_STATUS_OK or a BUS_ERROR_ code
+//===============================================================================
+unsigned char BusConfigAutoBaud(unsigned char mode) {
+    if (mode > UART_9BIT_MODE) {
+        return BUS_ERROR_FORMAT;
+    }
+    if (!BusClaim()) {
+        return BUS_ERROR_BUSY;
+    }
+    PIE1bits.RC1IE = 0;
+    busMode = mode;
+    UART_SetMode(UART1_INDEX, mode);
+    busState = BUS_STATE_DETECTING;
+    busSamples = 0;
+    busCount = 0xFFFF;
+    busStartTick = TickNow();
+    BusAutoBaudArm();
+    return HOST_STATUS_OK;
+}
+
+static void BusAutoBaudService(void) {
+    if (busSamples == BUS_AUTOBAUD_SAMPLES) {
+        // Confirming busCandidate, polled with the receive interrupt masked
+        while (PIR1bits.RC1IF) {
+            unsigned int data = GetChar9(UART1_INDEX);
+            if (data & UART_FAULT_FRAMING_ERROR) {
+                BusAutoBaudTry(busCandidate + 1);
+                return;
+            }
+            if (!(data & UART_FAULT_OVERRUN_ERROR) && ++busConfirmed == BUS_AUTOBAUD_CONFIRM_WORDS) {
+                BusAutoBaudFinish(BUS_STATE_LOCKED);
+                return;
+            }
+        }
+    } else if (BAUDCON1bits.ABDOVF) {
+        // Counter rolled over on an idle or slow bus, measure again
+        BAUDCON1bits.ABDEN = 0;
+        if (PIR1bits.RC1IF) {
+            (void)RCREG1;
+        }
+        BusAutoBaudArm();
+    } else if (!BAUDCON1bits.ABDEN) {
+        unsigned int count = ((unsigned int)SPBRGH1 << 8) | SPBRG1;
+        (void)RCREG1;                       // Clears RCIF, the byte is meaningless
+        if (count < busCount) {
+            busCount = count;
+        }
+        if (++busSamples == BUS_AUTOBAUD_SAMPLES) {
+            BusAutoBaudTry(0);
+            return;
+        }
+        BusAutoBaudArm();
+    }
+    if ((unsigned int)(TickNow() - busStartTick) >= BUS_AUTOBAUD_TIMEOUT_TICKS) {
+        BusAutoBaudFinish(BUS_STATE_NO_LOCK);
+    }
+}
+
+static void BusSendReport(void) {
+    unsigned char payload[BUS_CONFIG_REPORT_SIZE];
+
+    payload[0] = (busState == BUS_STATE_DETECTING) ? BUS_BAUD_AUTO : busBaudCode;
+    payload[1] = busMode;
+    payload[2] = busState;
+    payload[3] = (unsigned char)busCount;
+    payload[4] = (unsigned char)(busCount >> 8);
+    if (HostSendPacket(HOST_PACKET_BUS_CONFIG, payload, BUS_CONFIG_REPORT_SIZE)) {
+        busReportPending = FALSE;
+    }
+}
+
+// Call from the main loop
+void BusConfigService(void) {
+    if (busState == BUS_STATE_DETECTING) {
+        BusAutoBaudService();
+    }
+    if (busReportPending) {
+        BusSendReport();
+    }
+}
+
+unsigned char BusConfigHostCommand(const unsigned char* payload, unsigned char length) {
+    if (length == 0) {
+        busReportPending = TRUE;
+        return HOST_STATUS_OK;
+    }
+    if (length != 2) {
+        return BUS_ERROR_FORMAT;
+    }
+    if (payload[0] == BUS_BAUD_AUTO) {
+        return BusConfigAutoBaud(payload[1]);
+    }
+    return BusConfigSet(payload[0], payload[1]);
+}
@@ -0,0 +1,71 @@
+/*
+ * File:   busconfig.h
+ *
+ * Galaxy bus UART settings, changed at run time over the host link.
+ * HOST_COMMAND_BUS_CONFIG payload:
+ *
+ *     empty               send a HOST_PACKET_BUS_CONFIG report
+ *     baud code, mode     UART_BAUD_CODE_ rate, or BUS_BAUD_AUTO to detect
+ *                         it, and UART_8BIT_MODE or UART_9BIT_MODE
+ *
+ * Auto-baud measures BUS_AUTOBAUD_SAMPLES words with the BAUDCON1 ABDEN
+ * hardware. The Galaxy bus sends no 0x55 sync character, and ABD times
+ * five rising edges, which is 8 bit times only for alternating bits and
+ * longer for anything else. So the shortest measurement is at least 8 and
+ * usually 10 to 12 bit times of the real rate. Table rates it could be
+ * are tried slowest first, each until BUS_AUTOBAUD_CONFIRM_WORDS words
+ * arrive without a framing error. Received words are dropped while it
+ * runs. A report goes out when it finishes; without a lock the previous
+ * rate is restored.
+ * HOST_PACKET_BUS_CONFIG payload:
+ *
+ *     baud code           1 byte, BUS_BAUD_AUTO while detecting
+ *     mode                1 byte
+ *     state               1 byte, BUS_STATE_
+ *     ABD count           2 bytes LE, shortest auto-baud measurement, 0
+ *                         after a plain set
+ */
+
+#ifndef BUSCONFIG_H
+#define	BUSCONFIG_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#define BUS_BAUD_CODE_DEFAULT       UART_BAUD_CODE_19200
+#define BUS_MODE_DEFAULT            UART_9BIT_MODE
+#define BUS_BAUD_AUTO               0xFF
+
+#define BUS_AUTOBAUD_SAMPLES        32
+#define BUS_AUTOBAUD_TIMEOUT_TICKS  (2000000UL / TICK_PERIOD_US)
+#define BUS_AUTOBAUD_CONFIRM_WORDS  16
+#define BUS_AUTOBAUD_LOW_PERCENT    97      // Shortest count against the 8 bit count
+#define BUS_AUTOBAUD_HIGH_PERCENT   250     // 20 bit times
+
+#define BUS_CONFIG_REPORT_SIZE      5
+
+// Report states
+#define BUS_STATE_SET               0
+#define BUS_STATE_DETECTING         1
+#define BUS_STATE_LOCKED            2
+#define BUS_STATE_NO_LOCK           3
+
+// Host command status codes
+#define BUS_ERROR_FORMAT            1       // Bad length, rate or mode
+#define BUS_ERROR_BUSY              2       // UART1 still transmitting
+
+void BusConfigInitialize(void);
+unsigned char BusConfigSet(unsigned char baudCode, unsigned char mode);
+unsigned char BusConfigAutoBaud(unsigned char mode);
+unsigned char BusConfigDetecting(void);
+unsigned char BusConfigPending(void);
+void BusConfigService(void);
+unsigned char BusConfigHostCommand(const unsigned char* payload, unsigned char length);
+
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* BUSCONFIG_H */
@@ -0,0 +1,109 @@
+#include "app.h"
+#include "galaxy.h"
+#include "tick.h"
+#include "host.h"
+#include "capture.h"
+
+unsigned int captureDroppedPackets = 0;
+
+static unsigned char captureEnabled = FALSE;
+static unsigned char capturePayload[CAPTURE_PAYLOAD_SIZE];
+static unsigned char captureLength = 0;
+static unsigned char captureRecords = 0;
+static unsigned char captureSequence = 0;
+static unsigned long captureLastStamp = 0;
+static unsigned int captureStartTick = 0;
+
+void CaptureInitialize(void) {
+    captureEnabled = FALSE;
+    captureRecords = 0;
+    captureSequence = 0;
+    captureDroppedPackets = 0;
+}
+
+void CaptureEnable(unsigned char enable) {
+    if (!enable) {
+        CaptureFlush();
+    }
+    captureEnabled = enable;
+}
+
+unsigned char CaptureActive(void) {
+    return captureEnabled;
+}
+
+void CaptureWord(unsigned int word, unsigned long stamp) {
+    unsigned long delta;
+    unsigned char control;
+    unsigned char deltaBytes;
+
+    if (!captureEnabled) {
+        return;
+    }
+
+    if (captureRecords == 0) {
+        capturePayload[0] = captureSequence;
+        capturePayload[1] = (unsigned char)stamp;
+        capturePayload[2] = (unsigned char)(stamp >> 8);
+        capturePayload[3] = (unsigned char)(stamp >> 16);
+        capturePayload[4] = (unsigned char)(stamp >> 24);
+        captureLength = CAPTURE_HEADER_SIZE;
+        captureLastStamp = stamp;
+        captureStartTick = TickNow();
+    }
+
+    // Whole units only, the remainder goes into the next delta
+    delta = (stamp - captureLastStamp) >> CAPTURE_DELTA_UNIT_SHIFT;
+    if (delta > CAPTURE_DELTA_MAX) {
+        delta = CAPTURE_DELTA_MAX;
+        captureLastStamp = stamp;
+    } else {
+        captureLastStamp += delta << CAPTURE_DELTA_UNIT_SHIFT;
+    }
+    control = (word & GALAXY_ADDRESS_FLAG) ? CAPTURE_CONTROL_BIT8 : 0;
+
+    capturePayload[captureLength++] = (unsigned char)word;
+    if (delta <= CAPTURE_DELTA_SHORT_MAX && !(word & GALAXY_FAULT_MASK)) {
+        capturePayload[captureLength++] = control | (unsigned char)delta;
+    } else {
+        if (delta == 0) {
+            deltaBytes = 0;
+        } else if (delta <= 0xFF) {
+            deltaBytes = 1;
+        } else if (delta <= 0xFFFF) {
+            deltaBytes = 2;
+        } else {
+            deltaBytes = 3;
+        }
+        capturePayload[captureLength++] = control | CAPTURE_ESCAPE;
+        capturePayload[captureLength++] = ((unsigned char)(word >> 8) & 0x0F) | (deltaBytes << CAPTURE_DELTA_SHIFT);
+        for (unsigned char x=0; x < deltaBytes; x++) {
+            capturePayload[captureLength++] = (unsigned char)delta;
+            delta = delta >> 8;
+        }
+    }
+
+    captureRecords++;
+    if (captureLength > CAPTURE_PAYLOAD_SIZE - CAPTURE_RECORD_MAX_SIZE) {
+        CaptureFlush();
+    }
+}
+
+void CaptureFlush(void) {
+    if (captureRecords == 0) {
+        return;
+    }
+    // A dropped packet still uses up its sequence number so the host sees the gap
+    if (!HostSendPacket(HOST_PACKET_CAPTURE, capturePayload, captureLength)) {
+        captureDroppedPackets++;
+    }
+    captureSequence++;
+    captureRecords = 0;
+}
+
+// Call from the main loop to push out partial packets on a quiet bus
+void CaptureService(void) {
+    if (captureRecords != 0 && (unsigned int)(TickNow() - captureStartTick) >= CAPTURE_FLUSH_TICKS) {
+        CaptureFlush();
+    }
+}
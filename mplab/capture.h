@@ -0,0 +1,67 @@
+/* 
+ * File:   capture.h
+ *
+ * Binary capture stream of received Galaxy words, sent to the host as
+ * HOST_PACKET_CAPTURE packets. Payload:
+ *
+ *     sequence            1 byte, +1 per packet including dropped ones
+ *     base timestamp      4 bytes LE, timestamp of the first record
+ *     records...
+ *
+ * Deltas count CAPTURE_DELTA_UNIT timestamp units (8 us, about one bit
+ * time at 115200) since the previous record. The remainder is carried to
+ * the next record, so a decoded timestamp is never more than one unit
+ * behind the real one. A record is usually two bytes:
+ *
+ *     word low byte
+ *     control             bit 7: word bit 8 (9th bit); bits 0-6: delta,
+ *                         0 to CAPTURE_DELTA_SHORT_MAX, or CAPTURE_ESCAPE
+ *
+ * A record with UART fault bits or a longer delta has CAPTURE_ESCAPE in
+ * the control byte, and goes on with
+ *
+ *     flags               bits 0-3: word bits 8-11 (9th bit, framing
+ *                         error, overrun, no data); bits 4-5: number of
+ *                         delta bytes that follow (0-3)
+ *     delta               0-3 bytes LE, saturating at CAPTURE_DELTA_MAX
+ *
+ * Records are added until the next one might not fit the payload, or
+ * CAPTURE_FLUSH_TICKS after the first.
+ */
+
+#ifndef CAPTURE_H
+#define	CAPTURE_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#define CAPTURE_PAYLOAD_SIZE        85
+#define CAPTURE_HEADER_SIZE         5
+#define CAPTURE_RECORD_MIN_SIZE     2
+#define CAPTURE_RECORD_MAX_SIZE     6
+#define CAPTURE_FLUSH_TICKS         5       // Send a partial packet after this long
+
+#define CAPTURE_DELTA_UNIT_SHIFT    4
+#define CAPTURE_DELTA_UNIT          (1 << CAPTURE_DELTA_UNIT_SHIFT)     // Timestamp units
+#define CAPTURE_ESCAPE              0x7F
+#define CAPTURE_DELTA_SHORT_MAX     (CAPTURE_ESCAPE - 1)
+#define CAPTURE_CONTROL_BIT8        0x80
+#define CAPTURE_DELTA_SHIFT         4       // Delta byte count in the escape flags
+#define CAPTURE_DELTA_MAX           0xFFFFFFUL
+
+void CaptureInitialize(void);
+void CaptureEnable(unsigned char enable);
+unsigned char CaptureActive(void);
+void CaptureWord(unsigned int word, unsigned long stamp);
+void CaptureFlush(void);
+void CaptureService(void);
+
+extern unsigned int captureDroppedPackets;
+
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* CAPTURE_H */
@@ -1,50 +1,132 @@
+#include <xc.h>
 #include "app.h"
 #include "fifo.h"
 
 void FifoInitialize(buffer16* buffer) {
     buffer->read = 0;
     buffer->write = 0;
-    buffer->capacity = sizeof(buffer->buffer) / sizeof(buffer->buffer[0]);
-    buffer->currentCount = 0;
+    buffer->peak = 0;
+    buffer->failures = 0;
+    buffer->wraps = 0;
+    buffer->totalBase = 0;
 }
 
 unsigned char IsFifoFull(buffer16* buffer) {
-    if (buffer->currentCount == buffer->capacity) {
+    if ((unsigned char)(buffer->write - buffer->read) == FIFO_SIZE) {
         return TRUE;
     }
     return FALSE;
 }
 
 unsigned char IsFifoEmpty(buffer16* buffer) {
-    if (buffer->currentCount == 0) {
+    if (buffer->write == buffer->read) {
         return TRUE;
     }
     return FALSE;
 }
 
+// Exact for the caller's own side, a lower or upper bound for the other
+unsigned char FifoCount(buffer16* buffer) {
+    return (unsigned char)(buffer->write - buffer->read);
+}
+
+// Producer side only
 unsigned char FifoEnqueue(buffer16* buffer, unsigned int data) {
-    if (IsFifoFull(buffer)) {
+    unsigned char write = buffer->write;
+    unsigned char count = (unsigned char)(write - buffer->read);
+    if (count == FIFO_SIZE) {
+        buffer->failures++;
         return FALSE;
     }
-    buffer->buffer[buffer->write] = data;
-    buffer->write++;
-    if (buffer->write == FIFO_SIZE)
-        buffer->write = 0;
-    buffer->currentCount++;
+    if (count >= buffer->peak) {
+        buffer->peak = count + 1;
+    }
+#ifdef FIFO_PACKED_STORAGE
+    unsigned char slot = write & FIFO_MASK;
+    unsigned char upper = (unsigned char)(data >> 8) & 0x0F;
+    buffer->data[slot] = (unsigned char)data;
+    if (slot & 0x01) {
+        buffer->upper[slot >> 1] = (buffer->upper[slot >> 1] & 0x0F) | (upper << 4);
+    } else {
+        buffer->upper[slot >> 1] = (buffer->upper[slot >> 1] & 0xF0) | upper;
+    }
+#else
+    buffer->buffer[write & FIFO_MASK] = data;
+#endif
+    // Publish only after the data is stored
+    write++;
+    buffer->write = write;
+    if (write == 0) {
+        buffer->wraps++;
+    }
     return TRUE;
 }
 
+// Consumer side only
 unsigned int FifoDequeue(buffer16* buffer) {
     unsigned int data;
-    if (IsFifoEmpty(buffer)) {
+    unsigned char read = buffer->read;
+    if (buffer->write == read) {
         return FALSE;
     }
-    data = buffer->buffer[buffer->read];
-    buffer->read++;
-    if (buffer->read == FIFO_SIZE)
-        buffer->read = 0;
-    buffer->currentCount--;
+#ifdef FIFO_PACKED_STORAGE
+    unsigned char slot = read & FIFO_MASK;
+    unsigned char upper = buffer->upper[slot >> 1];
+    if (slot & 0x01) {
+        upper = upper >> 4;
+    }
+    data = ((unsigned int)(upper & 0x0F) << 8) | buffer->data[slot];
+#else
+    data = buffer->buffer[read & FIFO_MASK];
+#endif
+    // Release the slot only after the data is read
+    buffer->read = read + 1;
     return data;
 }
 
+// Producer side only
+unsigned char FifoEnqueueStamped(buffer16* buffer, volatile unsigned int* stamps, unsigned int data, unsigned int stamp) {
+    unsigned char write = buffer->write;
+    if ((unsigned char)(write - buffer->read) == FIFO_SIZE) {
+        buffer->failures++;
+        return FALSE;
+    }
+    // Stored before FifoEnqueue publishes the slot
+    stamps[write & FIFO_MASK] = stamp;
+    return FifoEnqueue(buffer, data);
+}
+
+// Consumer side only
+unsigned int FifoDequeueStamped(buffer16* buffer, volatile unsigned int* stamps, unsigned int* stamp) {
+    *stamp = stamps[buffer->read & FIFO_MASK];
+    return FifoDequeue(buffer);
+}
 
+//===============================================================================
+//	Description:	Copies the usage counters with interrupts masked, so an
+//					ISR producer cannot update them halfway through. A reset
+//					starts the next interval with the peak at the current
+//					count rather than zero.
+//
+//	Params:			BUFFER			buffer16*	FIFO to read
+//					SNAPSHOT		fifoStats*	Receives the counters
+//					RESET			UCHAR		TRUE to restart the counters
+//
+//	Returns:			NONE
+//===============================================================================
+void FifoStatsSnapshot(buffer16* buffer, fifoStats* snapshot, unsigned char reset) {
+    unsigned char interrupts = INTCONbits.GIEH;
+    unsigned long total;
+
+    INTCONbits.GIEH = 0;
+    total = ((unsigned long)buffer->wraps << 8) | buffer->write;
+    snapshot->peak = buffer->peak;
+    snapshot->failures = buffer->failures;
+    snapshot->total = total - buffer->totalBase;
+    if (reset) {
+        buffer->peak = (unsigned char)(buffer->write - buffer->read);
+        buffer->failures = 0;
+        buffer->totalBase = total;
+    }
+    INTCONbits.GIEH = interrupts;
+}
@@ -12,22 +12,69 @@
 extern "C" {
 #endif
 
-    
-    
+// Single-producer/single-consumer ring. Only the producer writes 'write'
+// and only the consumer writes 'read', so one side may run in an ISR and
+// the other in main() without masking interrupts. Both indexes run free
+// and wrap through FIFO_MASK; write - read is the current count.
+#if (FIFO_SIZE & (FIFO_SIZE - 1)) != 0 || FIFO_SIZE > 128
+#error "FIFO_SIZE must be a power of two no larger than 128"
+#endif
+#define FIFO_MASK (FIFO_SIZE - 1)
+
+//
+// With FIFO_PACKED_STORAGE each word keeps its low 8 bits in data[] and
+// bits 8-11 (9th bit and UART fault flags) in a nibble of upper[]. Words
+// wider than 12 bits are truncated. Only the producer writes either array.
+//
+// peak, failures and wraps are usage counters kept by the producer. wraps
+// counts write passing through zero, so the words enqueued so far are
+// wraps * 256 + write without a 32 bit add per word.
+#ifdef FIFO_PACKED_STORAGE
 typedef struct {
-    unsigned int buffer[FIFO_SIZE];
-    unsigned char read;
-    unsigned char write;
-    unsigned char currentCount;
-    unsigned char capacity;
+    volatile unsigned char data[FIFO_SIZE];
+    volatile unsigned char upper[FIFO_SIZE / 2];
+    volatile unsigned char read;
+    volatile unsigned char write;
+    volatile unsigned char peak;            // Most words held at once
+    volatile unsigned int failures;         // Enqueues refused when full
+    volatile unsigned int wraps;
+    unsigned long totalBase;                // Enqueued count at the last reset
 } buffer16;
+#else
+typedef struct {
+    volatile unsigned int buffer[FIFO_SIZE];
+    volatile unsigned char read;
+    volatile unsigned char write;
+    volatile unsigned char peak;            // Most words held at once
+    volatile unsigned int failures;         // Enqueues refused when full
+    volatile unsigned int wraps;
+    unsigned long totalBase;                // Enqueued count at the last reset
+} buffer16;
+#endif
+
+// Usage since FifoInitialize or the last reset
+typedef struct {
+    unsigned char peak;
+    unsigned int failures;
+    unsigned long total;                    // Words enqueued
+} fifoStats;
+
+extern buffer16 buffers[FIFO_COUNT];
 
 void FifoInitialize(buffer16 * buffer);
 unsigned char IsFifoFull(buffer16 * buffer);
 unsigned char IsFifoEmpty(buffer16 * buffer);
+unsigned char FifoCount(buffer16 * buffer);
 unsigned char FifoEnqueue(buffer16* buffer, unsigned int data);
 unsigned int FifoDequeue(buffer16* buffer);
 
+// Keep the low half of a timestamp per word in a caller supplied
+// stamps[FIFO_SIZE], see TimestampExtend
+unsigned char FifoEnqueueStamped(buffer16* buffer, volatile unsigned int* stamps, unsigned int data, unsigned int stamp);
+unsigned int FifoDequeueStamped(buffer16* buffer, volatile unsigned int* stamps, unsigned int* stamp);
+
+void FifoStatsSnapshot(buffer16* buffer, fifoStats* snapshot, unsigned char reset);
+
 #ifdef	__cplusplus
 }
 #endif
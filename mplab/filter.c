@@ -0,0 +1,165 @@
+#include <xc.h>
+#include "app.h"
+#include "galaxy.h"
+#include "filter.h"
+
+// Filter states
+#define FILTER_STATE_HUNT           0       // Waiting for an address word
+#define FILTER_STATE_PENDING        1       // Collecting address, length and command
+#define FILTER_STATE_PASS           2
+#define FILTER_STATE_DROP           3
+
+filterWord filterOutput[FILTER_PENDING_SIZE];
+unsigned long filterDropped = 0;
+
+static unsigned char filterMode = FILTER_MODE_OFF;
+static unsigned char filterState = FILTER_STATE_HUNT;
+static unsigned char filterCount = 0;
+static unsigned char filterAddresses[32];   // One bit per address low byte
+static unsigned char filterCommands[32];
+static unsigned char filterAnyAddress = TRUE;
+static unsigned char filterAnyCommand = TRUE;
+
+static unsigned char FilterBit(const unsigned char* map, unsigned char value) {
+    return map[value >> 3] & (1 << (value & 0x07));
+}
+
+void FilterInitialize(void) {
+    FilterConfigure(FILTER_MODE_OFF);
+    filterDropped = 0;
+}
+
+// Clears both lists (accept everything) and sets the mode
+void FilterConfigure(unsigned char mode) {
+    unsigned char interrupts = INTCONbits.GIEH;
+
+    for (unsigned char x=0; x < 32; x++) {
+        filterAddresses[x] = 0;
+        filterCommands[x] = 0;
+    }
+    filterAnyAddress = TRUE;
+    filterAnyCommand = TRUE;
+    filterState = FILTER_STATE_HUNT;
+    filterCount = 0;
+    filterMode = mode;
+
+    // The receive ISR also writes RCSTA1
+    INTCONbits.GIEH = 0;
+    RCSTA1bits.ADDEN = (mode & FILTER_MODE_HARDWARE) ? 1 : 0;
+    INTCONbits.GIEH = interrupts;
+}
+
+void FilterAcceptAddress(unsigned char address) {
+    filterAddresses[address >> 3] |= (1 << (address & 0x07));
+    filterAnyAddress = FALSE;
+}
+
+void FilterAcceptCommand(unsigned char command) {
+    filterCommands[command >> 3] |= (1 << (command & 0x07));
+    filterAnyCommand = FALSE;
+}
+
+//===============================================================================
+//	Description:	Runs one received word through the filter. Passed words
+//					are left in filterOutput[] in bus order.
+//
+//	Params:			WORD			UINT		Received word, fault bits included
+//					STAMP			ULONG		Receive timestamp
+//
+//	Returns:			Number of words in filterOutput[] to process, 0 if the
+//					word was held or dropped
+//===============================================================================
+unsigned char FilterWord(unsigned int word, unsigned long stamp) {
+    unsigned char count;
+
+    if (filterMode == FILTER_MODE_OFF) {
+        filterOutput[0].word = word;
+        filterOutput[0].stamp = stamp;
+        return 1;
+    }
+
+    if ((word & GALAXY_ADDRESS_FLAG) && !(word & GALAXY_FAULT_MASK)) {
+        // A frame cut short before its command word is dropped
+        if (filterState == FILTER_STATE_PENDING) {
+            filterDropped += filterCount;
+        }
+        if (!filterAnyAddress && !FilterBit(filterAddresses, (unsigned char)word)) {
+            filterState = FILTER_STATE_DROP;
+            filterDropped++;
+            return 0;
+        }
+        filterState = filterAnyCommand ? FILTER_STATE_PASS : FILTER_STATE_PENDING;
+        filterCount = 0;
+    }
+
+    switch (filterState) {
+        case FILTER_STATE_PASS:
+            filterOutput[0].word = word;
+            filterOutput[0].stamp = stamp;
+            return 1;
+
+        case FILTER_STATE_PENDING:
+            filterOutput[filterCount].word = word;
+            filterOutput[filterCount].stamp = stamp;
+            filterCount++;
+            if (filterCount < FILTER_PENDING_SIZE) {
+                return 0;
+            }
+            if (FilterBit(filterCommands, (unsigned char)word)) {
+                filterState = FILTER_STATE_PASS;
+                count = filterCount;
+                filterCount = 0;
+                return count;
+            }
+            filterState = FILTER_STATE_DROP;
+            filterDropped += filterCount;
+            filterCount = 0;
+            return 0;
+
+        default:
+            filterDropped++;
+            return 0;
+    }
+}
+
+// Called from the receive ISR for each word. Arms ADDEN after a rejected
+// address so the data words that follow never raise RC1IF.
+void FilterReceiveInterrupt(unsigned int word) {
+    if ((filterMode & FILTER_MODE_HARDWARE) && (word & GALAXY_ADDRESS_FLAG)) {
+        RCSTA1bits.ADDEN = (!filterAnyAddress && !FilterBit(filterAddresses, (unsigned char)word)) ? 1 : 0;
+    }
+}
+
+// Host payload: mode, address count, addresses, command count, commands.
+// Empty lists accept everything.
+unsigned char FilterHostSet(const unsigned char* payload, unsigned char length) {
+    unsigned char addresses;
+    unsigned char commands;
+
+    if (length < 3) {
+        return FILTER_ERROR_LENGTH;
+    }
+    addresses = payload[1];
+    if (length < 3 + addresses) {
+        return FILTER_ERROR_LENGTH;
+    }
+    commands = payload[2 + addresses];
+    if (length != 3 + addresses + commands) {
+        return FILTER_ERROR_LENGTH;
+    }
+    if (payload[0] & ~(FILTER_MODE_ON | FILTER_MODE_HARDWARE)) {
+        return FILTER_ERROR_MODE;
+    }
+    if (payload[0] == FILTER_MODE_HARDWARE) {
+        return FILTER_ERROR_MODE;
+    }
+
+    FilterConfigure(payload[0]);
+    for (unsigned char x=0; x < addresses; x++) {
+        FilterAcceptAddress(payload[2 + x]);
+    }
+    for (unsigned char x=0; x < commands; x++) {
+        FilterAcceptCommand(payload[3 + addresses + x]);
+    }
+    return FILTER_OK;
+}
@@ -0,0 +1,54 @@
+/* 
+ * File:   filter.h
+ *
+ * Address and command filter for the breakout and capture paths. A frame
+ * is held until its address and command words are in, then passed or
+ * dropped as a whole. The decoder and poller still see every word.
+ *
+ * FILTER_MODE_HARDWARE also uses the EUSART's ADDEN address detect: after
+ * a rejected address word the UART ignores data words until the next
+ * address, so rejected frames cost no receive interrupts. The decoder and
+ * poller then miss those frames too.
+ */
+
+#ifndef FILTER_H
+#define	FILTER_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#define FILTER_MODE_OFF             0x00
+#define FILTER_MODE_ON              0x01
+#define FILTER_MODE_HARDWARE        0x02    // With FILTER_MODE_ON
+
+#define FILTER_COMMAND_INDEX        2       // Address, length, command
+#define FILTER_PENDING_SIZE         (FILTER_COMMAND_INDEX + 1)
+
+// Status codes
+#define FILTER_OK                   0
+#define FILTER_ERROR_LENGTH         1
+#define FILTER_ERROR_MODE           2
+
+typedef struct {
+    unsigned int word;
+    unsigned long stamp;
+} filterWord;
+
+extern filterWord filterOutput[FILTER_PENDING_SIZE];
+extern unsigned long filterDropped;
+
+void FilterInitialize(void);
+void FilterConfigure(unsigned char mode);
+void FilterAcceptAddress(unsigned char address);
+void FilterAcceptCommand(unsigned char command);
+unsigned char FilterWord(unsigned int word, unsigned long stamp);
+void FilterReceiveInterrupt(unsigned int word);
+unsigned char FilterHostSet(const unsigned char* payload, unsigned char length);
+
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* FILTER_H */
@@ -1,11 +1,207 @@
 #include "app.h"
 #include "galaxy.h"
 
+// CRC-16/MODBUS (reflected polynomial 0xA001, initial value 0xFFFF).
+// The 256-entry table is split into high and low byte tables so it costs
+// 512 bytes of flash once and indexes with single byte loads. Builds short
+// on flash can define GALAXY_CRC_NIBBLE_TABLE for a 32-byte table that
+// takes two lookups per byte instead.
+#ifdef GALAXY_CRC_NIBBLE_TABLE
+const unsigned short table_crc_nibble[16] = {
+    0x0000, 0xCC01, 0xD801, 0x1400, 0xF001, 0x3C00, 0x2800, 0xE401,
+    0xA001, 0x6C00, 0x7800, 0xB401, 0x5000, 0x9C01, 0x8801, 0x4400
+};
+#else
+const unsigned char table_crc_high[256] = {
+    0x00, 0xC0, 0xC1, 0x01, 0xC3, 0x03, 0x02, 0xC2, 0xC6, 0x06, 0x07, 0xC7, 0x05, 0xC5, 0xC4, 0x04,
+    0xCC, 0x0C, 0x0D, 0xCD, 0x0F, 0xCF, 0xCE, 0x0E, 0x0A, 0xCA, 0xCB, 0x0B, 0xC9, 0x09, 0x08, 0xC8,
+    0xD8, 0x18, 0x19, 0xD9, 0x1B, 0xDB, 0xDA, 0x1A, 0x1E, 0xDE, 0xDF, 0x1F, 0xDD, 0x1D, 0x1C, 0xDC,
+    0x14, 0xD4, 0xD5, 0x15, 0xD7, 0x17, 0x16, 0xD6, 0xD2, 0x12, 0x13, 0xD3, 0x11, 0xD1, 0xD0, 0x10,
+    0xF0, 0x30, 0x31, 0xF1, 0x33, 0xF3, 0xF2, 0x32, 0x36, 0xF6, 0xF7, 0x37, 0xF5, 0x35, 0x34, 0xF4,
+    0x3C, 0xFC, 0xFD, 0x3D, 0xFF, 0x3F, 0x3E, 0xFE, 0xFA, 0x3A, 0x3B, 0xFB, 0x39, 0xF9, 0xF8, 0x38,
+    0x28, 0xE8, 0xE9, 0x29, 0xEB, 0x2B, 0x2A, 0xEA, 0xEE, 0x2E, 0x2F, 0xEF, 0x2D, 0xED, 0xEC, 0x2C,
+    0xE4, 0x24, 0x25, 0xE5, 0x27, 0xE7, 0xE6, 0x26, 0x22, 0xE2, 0xE3, 0x23, 0xE1, 0x21, 0x20, 0xE0,
+    0xA0, 0x60, 0x61, 0xA1, 0x63, 0xA3, 0xA2, 0x62, 0x66, 0xA6, 0xA7, 0x67, 0xA5, 0x65, 0x64, 0xA4,
+    0x6C, 0xAC, 0xAD, 0x6D, 0xAF, 0x6F, 0x6E, 0xAE, 0xAA, 0x6A, 0x6B, 0xAB, 0x69, 0xA9, 0xA8, 0x68,
+    0x78, 0xB8, 0xB9, 0x79, 0xBB, 0x7B, 0x7A, 0xBA, 0xBE, 0x7E, 0x7F, 0xBF, 0x7D, 0xBD, 0xBC, 0x7C,
+    0xB4, 0x74, 0x75, 0xB5, 0x77, 0xB7, 0xB6, 0x76, 0x72, 0xB2, 0xB3, 0x73, 0xB1, 0x71, 0x70, 0xB0,
+    0x50, 0x90, 0x91, 0x51, 0x93, 0x53, 0x52, 0x92, 0x96, 0x56, 0x57, 0x97, 0x55, 0x95, 0x94, 0x54,
+    0x9C, 0x5C, 0x5D, 0x9D, 0x5F, 0x9F, 0x9E, 0x5E, 0x5A, 0x9A, 0x9B, 0x5B, 0x99, 0x59, 0x58, 0x98,
+    0x88, 0x48, 0x49, 0x89, 0x4B, 0x8B, 0x8A, 0x4A, 0x4E, 0x8E, 0x8F, 0x4F, 0x8D, 0x4D, 0x4C, 0x8C,
+    0x44, 0x84, 0x85, 0x45, 0x87, 0x47, 0x46, 0x86, 0x82, 0x42, 0x43, 0x83, 0x41, 0x81, 0x80, 0x40
+};
+
+const unsigned char table_crc_low[256] = {
+    0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41, 0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40,
+    0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40, 0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41,
+    0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40, 0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41,
+    0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41, 0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40,
+    0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40, 0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41,
+    0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41, 0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40,
+    0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41, 0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40,
+    0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40, 0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41,
+    0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40, 0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41,
+    0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41, 0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40,
+    0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41, 0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40,
+    0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40, 0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41,
+    0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41, 0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40,
+    0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40, 0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41,
+    0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40, 0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41,
+    0x00, 0xC1, 0x81, 0x40, 0x01, 0xC0, 0x80, 0x41, 0x01, 0xC0, 0x80, 0x41, 0x00, 0xC1, 0x81, 0x40
+};
+#endif
+
+unsigned short crc_update(unsigned short crc, unsigned char data) {
+#ifdef GALAXY_CRC_NIBBLE_TABLE
+    crc = (crc >> 4) ^ table_crc_nibble[(crc ^ data) & 0x0F];
+    crc = (crc >> 4) ^ table_crc_nibble[(crc ^ (data >> 4)) & 0x0F];
+    return crc;
+#else
+    unsigned char index = (unsigned char)crc ^ data;
+    return (((unsigned short)table_crc_high[index] << 8) | (crc >> 8)) ^ table_crc_low[index];
+#endif
+}
 
 unsigned short compute_crc( unsigned int *ptr_msg_body, int len_body) {
     int i;
-    unsigned short crc = 0xffff; /* Initial Value */
+    unsigned short crc = GALAXY_CRC_INITIAL;
     for (i = 0; i < len_body; i ++)
-        crc = ((crc >> 8) & 0xFF) ^ table_crc[(crc ^ (*ptr_msg_body++ & 0xFF)) & 0xFF];
+        crc = crc_update(crc, (unsigned char)*ptr_msg_body++);
     return crc;
 }
+
+void GalaxyBufferClear(galaxyBuffer* frame) {
+    frame->word_count = 0;
+    for (unsigned char x=0; x < sizeof(frame->ninth); x++) {
+        frame->ninth[x] = 0;
+    }
+}
+
+unsigned char GalaxyBufferAppend(galaxyBuffer* frame, unsigned int word) {
+    unsigned char index = frame->word_count;
+    if (index >= GALAXY_BUFFER_SIZE) {
+        return FALSE;
+    }
+    frame->buffer[index] = (unsigned char)word;
+    if ((word & 0x0100) == 0x0100) {
+        frame->ninth[index >> 3] |= (unsigned char)(1 << (index & 0x07));
+    } else {
+        frame->ninth[index >> 3] &= (unsigned char)~(1 << (index & 0x07));
+    }
+    frame->word_count++;
+    return TRUE;
+}
+
+unsigned int GalaxyBufferGet(galaxyBuffer* frame, unsigned char index) {
+    unsigned int word = frame->buffer[index];
+    if (frame->ninth[index >> 3] & (unsigned char)(1 << (index & 0x07))) {
+        word |= 0x0100;
+    }
+    return word;
+}
+
+unsigned short GalaxyBufferCrc(galaxyBuffer* frame) {
+    unsigned short crc = GALAXY_CRC_INITIAL;
+    for (unsigned char i = 0; i < frame->word_count; i++)
+        crc = crc_update(crc, frame->buffer[i]);
+    return crc;
+}
+
+void GalaxyDecoderInitialize(galaxyDecoder* decoder) {
+    decoder->read = 0;
+    decoder->write = 0;
+    decoder->state = GALAXY_STATE_HUNT;
+}
+
+// Starts a new frame at an address word, or skips it if the queue is full
+static unsigned char GalaxyDecodeAddress(galaxyDecoder* decoder, unsigned int word, unsigned long stamp) {
+    galaxyBuffer* frame;
+
+    if ((unsigned char)(decoder->write - decoder->read) == GALAXY_FRAME_QUEUE_SIZE) {
+        decoder->state = GALAXY_STATE_DROP;
+        return GALAXY_DECODE_DROPPED;
+    }
+    frame = &decoder->frames[decoder->write & (GALAXY_FRAME_QUEUE_SIZE - 1)];
+    GalaxyBufferClear(frame);
+    GalaxyBufferAppend(frame, word);
+    frame->timestamp = stamp;
+    decoder->crc = crc_update(GALAXY_CRC_INITIAL, (unsigned char)word);
+    decoder->state = GALAXY_STATE_LENGTH;
+    return GALAXY_DECODE_NONE;
+}
+
+unsigned char GalaxyDecode(galaxyDecoder* decoder, unsigned int word, unsigned long stamp) {
+    galaxyBuffer* frame = &decoder->frames[decoder->write & (GALAXY_FRAME_QUEUE_SIZE - 1)];
+    unsigned char state = decoder->state;
+    unsigned char result = GALAXY_DECODE_NONE;
+
+    if (word & GALAXY_FAULT_MASK) {
+        decoder->state = GALAXY_STATE_HUNT;
+        if (state == GALAXY_STATE_HUNT || state == GALAXY_STATE_DROP) {
+            return GALAXY_DECODE_NONE;
+        }
+        return GALAXY_DECODE_FAULT;
+    }
+
+    // An address word always starts a new frame, cutting off any frame in progress
+    if (word & GALAXY_ADDRESS_FLAG) {
+        if (state != GALAXY_STATE_HUNT && state != GALAXY_STATE_DROP) {
+            result = GALAXY_DECODE_LENGTH_ERROR;
+        }
+        if (GalaxyDecodeAddress(decoder, word, stamp) == GALAXY_DECODE_DROPPED) {
+            return GALAXY_DECODE_DROPPED;
+        }
+        return result;
+    }
+
+    switch (state) {
+        case GALAXY_STATE_LENGTH:
+            if (word < GALAXY_MIN_FRAME_WORDS || word > GALAXY_MAX_FRAME_WORDS) {
+                decoder->state = GALAXY_STATE_HUNT;
+                return GALAXY_DECODE_LENGTH_ERROR;
+            }
+            decoder->expected = (unsigned char)word - 2;
+            decoder->state = GALAXY_STATE_BODY;
+            // Fall through to store the length word
+        case GALAXY_STATE_BODY:
+            GalaxyBufferAppend(frame, word);
+            decoder->crc = crc_update(decoder->crc, (unsigned char)word);
+            if (frame->word_count == decoder->expected) {
+                decoder->state = GALAXY_STATE_CRC_HIGH;
+            }
+            break;
+
+        case GALAXY_STATE_CRC_HIGH:
+            frame->crc = word << 8;
+            decoder->state = GALAXY_STATE_CRC_LOW;
+            break;
+
+        case GALAXY_STATE_CRC_LOW:
+            frame->crc |= word;
+            frame->end_timestamp = stamp;
+            decoder->state = GALAXY_STATE_HUNT;
+            if (frame->crc != decoder->crc) {
+                return GALAXY_DECODE_CRC_ERROR;
+            }
+            decoder->write++;
+            return GALAXY_DECODE_FRAME;
+
+        default:
+            // HUNT and DROP ignore data words
+            break;
+    }
+    return GALAXY_DECODE_NONE;
+}
+
+galaxyBuffer* GalaxyFramePeek(galaxyDecoder* decoder) {
+    if (decoder->write == decoder->read) {
+        return 0;
+    }
+    return &decoder->frames[decoder->read & (GALAXY_FRAME_QUEUE_SIZE - 1)];
+}
+
+void GalaxyFrameRelease(galaxyDecoder* decoder) {
+    if (decoder->write != decoder->read) {
+        decoder->read++;
+    }
+}
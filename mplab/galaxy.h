@@ -1,52 +1,105 @@
 #include "app.h"
 
-#ifndef GALAXY_CRC16_TABLE
-#define GALAXY_CRC16_TABLE
-unsigned int const table_crc[256] = {
-    0x0000, 0xC0C1, 0xC181, 0x0140, 0xC301, 0x03C0, 0x0280, 0xC241,
-    0xC601, 0x06C0, 0x0780, 0xC741, 0x0500, 0xC5C1, 0xC481, 0x0440,
-    0xCC01, 0x0CC0, 0x0D80, 0xCD41, 0x0F00, 0xCFC1, 0xCE81, 0x0E40,
-    0x0A00, 0xCAC1, 0xCB81, 0x0B40, 0xC901, 0x09C0, 0x0880, 0xC841,
-    0xD801, 0x18C0, 0x1980, 0xD941, 0x1B00, 0xDBC1, 0xDA81, 0x1A40,
-    0x1E00, 0xDEC1, 0xDF81, 0x1F40, 0xDD01, 0x1DC0, 0x1C80, 0xDC41,
-    0x1400, 0xD4C1, 0xD581, 0x1540, 0xD701, 0x17C0, 0x1680, 0xD641,
-    0xD201, 0x12C0, 0x1380, 0xD341, 0x1100, 0xD1C1, 0xD081, 0x1040,
-    0xF001, 0x30C0, 0x3180, 0xF141, 0x3300, 0xF3C1, 0xF281, 0x3240,
-    0x3600, 0xF6C1, 0xF781, 0x3740, 0xF501, 0x35C0, 0x3480, 0xF441,
-    0x3C00, 0xFCC1, 0xFD81, 0x3D40, 0xFF01, 0x3FC0, 0x3E80, 0xFE41,
-    0xFA01, 0x3AC0, 0x3B80, 0xFB41, 0x3900, 0xF9C1, 0xF881, 0x3840,
-    0x2800, 0xE8C1, 0xE981, 0x2940, 0xEB01, 0x2BC0, 0x2A80, 0xEA41,
-    0xEE01, 0x2EC0, 0x2F80, 0xEF41, 0x2D00, 0xEDC1, 0xEC81, 0x2C40,
-    0xE401, 0x24C0, 0x2580, 0xE541, 0x2700, 0xE7C1, 0xE681, 0x2640,
-    0x2200, 0xE2C1, 0xE381, 0x2340, 0xE101, 0x21C0, 0x2080, 0xE041,
-    0xA001, 0x60C0, 0x6180, 0xA141, 0x6300, 0xA3C1, 0xA281, 0x6240,
-    0x6600, 0xA6C1, 0xA781, 0x6740, 0xA501, 0x65C0, 0x6480, 0xA441,
-    0x6C00, 0xACC1, 0xAD81, 0x6D40, 0xAF01, 0x6FC0, 0x6E80, 0xAE41,
-    0xAA01, 0x6AC0, 0x6B80, 0xAB41, 0x6900, 0xA9C1, 0xA881, 0x6840,
-    0x7800, 0xB8C1, 0xB981, 0x7940, 0xBB01, 0x7BC0, 0x7A80, 0xBA41,
-    0xBE01, 0x7EC0, 0x7F80, 0xBF41, 0x7D00, 0xBDC1, 0xBC81, 0x7C40,
-    0xB401, 0x74C0, 0x7580, 0xB541, 0x7700, 0xB7C1, 0xB681, 0x7640,
-    0x7200, 0xB2C1, 0xB381, 0x7340, 0xB101, 0x71C0, 0x7080, 0xB041,
-    0x5000, 0x90C1, 0x9181, 0x5140, 0x9301, 0x53C0, 0x5280, 0x9241,
-    0x9601, 0x56C0, 0x5780, 0x9741, 0x5500, 0x95C1, 0x9481, 0x5440,
-    0x9C01, 0x5CC0, 0x5D80, 0x9D41, 0x5F00, 0x9FC1, 0x9E81, 0x5E40,
-    0x5A00, 0x9AC1, 0x9B81, 0x5B40, 0x9901, 0x59C0, 0x5880, 0x9841,
-    0x8801, 0x48C0, 0x4980, 0x8941, 0x4B00, 0x8BC1, 0x8A81, 0x4A40,
-    0x4E00, 0x8EC1, 0x8F81, 0x4F40, 0x8D01, 0x4DC0, 0x4C80, 0x8C41,
-    0x4400, 0x84C1, 0x8581, 0x4540, 0x8701, 0x47C0, 0x4680, 0x8641,
-    0x8201, 0x42C0, 0x4380, 0x8341, 0x4100, 0x81C1, 0x8081, 0x4040
-};
+#ifndef GALAXY_H
+#define	GALAXY_H
+
+#ifdef	__cplusplus
+extern "C" {
 #endif
 
 #define GALAXY_BUFFER_SIZE 20
 #define GALAXY_MAX_SLOTS 3
-#define GALAXY_COMMAND_COUNT (5)
 
+// Frame layout: address (9th bit set), length, command, payload, CRC high,
+// CRC low. The length field counts every word including address and CRC.
+#define GALAXY_ADDRESS_FLAG         0x0100
+#define GALAXY_FAULT_MASK           0x0E00
+#define GALAXY_MIN_FRAME_WORDS      5
+#define GALAXY_MAX_FRAME_WORDS      (GALAXY_BUFFER_SIZE + 2)
+#define GALAXY_FRAME_QUEUE_SIZE     4       // Power of two
+
+#define GALAXY_CRC_INITIAL          0xFFFF
+
+// Only address words carry the 9th bit, so words are stored as bytes with
+// the 9th bit in a separate bitmap. Use the GalaxyBuffer* accessors.
 typedef struct {
-    unsigned int buffer[GALAXY_BUFFER_SIZE];
+    unsigned char buffer[GALAXY_BUFFER_SIZE];
+    unsigned char ninth[(GALAXY_BUFFER_SIZE + 7) / 8];
     unsigned char word_count;
     unsigned int crc;
+    unsigned long timestamp;                // First word received
+    unsigned long end_timestamp;            // Last CRC word received
 } galaxyBuffer;
 
+// Command table, generated into flash from galaxy_commands.def
+#define GALAXY_BROADCAST_ADDRESS    0x01FF
+#define GALAXY_COMMAND_MAX_PAYLOAD  3
+#define GALAXY_COMMAND_MAX_WORDS    (GALAXY_COMMAND_MAX_PAYLOAD + 5)
+
+enum {
+#define GALAXY_COMMAND(name, opcode, payload) \
+    GALAXY_CMD_##name,
+#define GALAXY_SLOT_COMMAND(name, opcode) \
+    GALAXY_CMD_##name, GALAXY_CMD_##name##_LAST = GALAXY_CMD_##name + GALAXY_MAX_SLOTS - 1,
+#include "galaxy_commands.def"
+#undef GALAXY_COMMAND
+#undef GALAXY_SLOT_COMMAND
+    GALAXY_COMMAND_COUNT
+};
+
+// Complete frame as transmitted, CRC included. words[0] is the low byte of
+// the address word; its 9th bit is implied.
+typedef struct {
+    unsigned char word_count;
+    unsigned char words[GALAXY_COMMAND_MAX_WORDS];
+} galaxyCommand;
+
+// Unsized, so galaxy_commands.c can check its own entry count against
+// GALAXY_COMMAND_COUNT
+extern const galaxyCommand galaxyCommands[];
+
+// Decoder states
+#define GALAXY_STATE_HUNT           0       // Waiting for an address word
+#define GALAXY_STATE_LENGTH         1
+#define GALAXY_STATE_BODY           2
+#define GALAXY_STATE_CRC_HIGH       3
+#define GALAXY_STATE_CRC_LOW        4
+#define GALAXY_STATE_DROP           5       // Frame queue full, skip to next address
+
+// GalaxyDecode results
+#define GALAXY_DECODE_NONE          0       // Word consumed, frame incomplete
+#define GALAXY_DECODE_FRAME         1       // Valid frame queued
+#define GALAXY_DECODE_CRC_ERROR     2
+#define GALAXY_DECODE_LENGTH_ERROR  3       // Bad length field or truncated frame
+#define GALAXY_DECODE_FAULT         4       // UART fault flag inside a frame
+#define GALAXY_DECODE_DROPPED       5       // Frame queue full
+
+// Streaming decoder. Consumes one received word per GalaxyDecode call in
+// constant time and queues frames whose CRC checks out. Frames in the
+// queue hold the words up to the CRC; crc is the received CRC.
+typedef struct {
+    galaxyBuffer frames[GALAXY_FRAME_QUEUE_SIZE];
+    unsigned char read;
+    unsigned char write;
+    unsigned char state;
+    unsigned char expected;                 // Words before the CRC
+    unsigned short crc;                     // Running CRC of the current frame
+} galaxyDecoder;
+
+
+unsigned short crc_update(unsigned short crc, unsigned char data);
+unsigned short compute_crc( unsigned int *ptr_msg_body, int len_body);
+void GalaxyBufferClear(galaxyBuffer* frame);
+unsigned char GalaxyBufferAppend(galaxyBuffer* frame, unsigned int word);
+unsigned int GalaxyBufferGet(galaxyBuffer* frame, unsigned char index);
+unsigned short GalaxyBufferCrc(galaxyBuffer* frame);
+void GalaxyDecoderInitialize(galaxyDecoder* decoder);
+unsigned char GalaxyDecode(galaxyDecoder* decoder, unsigned int word, unsigned long stamp);
+galaxyBuffer* GalaxyFramePeek(galaxyDecoder* decoder);
+void GalaxyFrameRelease(galaxyDecoder* decoder);
+
+#ifdef	__cplusplus
+}
+#endif
 
-unsigned short compute_crc( unsigned int *ptr_msg_body, int len_body);
\ No newline at end of file
+#endif	/* GALAXY_H */
@@ -0,0 +1,26 @@
+/*
+ * File:   galaxy_commands.c
+ *
+ * Generated from galaxy_commands.def by tools/galaxy_cmdgen - do not edit!
+ * Regenerate with 'make commands'.
+ */
+
+#include "app.h"
+#include "galaxy.h"
+
+const galaxyCommand galaxyCommands[] = {
+    // DISCONNECT
+    { 7, { 0xFF, 0x07, 0x57, 0x04, 0x01, 0xB0, 0x43 } },
+    // CHOOSE_SLOT
+    { 6, { 0xFF, 0x06, 0x43, 0x02, 0xC0, 0x60 } },
+    // POLL_SLOT 0
+    { 6, { 0xFF, 0x06, 0x50, 0x00, 0x31, 0xEC } },
+    // POLL_SLOT 1
+    { 6, { 0xFF, 0x06, 0x50, 0x01, 0xF1, 0x2D } },
+    // POLL_SLOT 2
+    { 6, { 0xFF, 0x06, 0x50, 0x02, 0xF0, 0x6D } },
+};
+
+// Fails to compile when this table is stale, run 'make commands'
+typedef char galaxyCommandsComplete[sizeof(galaxyCommands) / sizeof(galaxyCommands[0])
+                                    == GALAXY_COMMAND_COUNT ? 1 : -1];
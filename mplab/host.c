@@ -0,0 +1,156 @@
+#include "app.h"
+#include "fifo.h"
+#include "uart.h"
+#include "galaxy.h"
+#include "host.h"
+#include "trigger.h"
+#include "filter.h"
+#include "stats.h"
+#include "replay.h"
+#include "busconfig.h"
+#include "bridge.h"
+#include "profile.h"
+
+static unsigned char hostRx[3 + HOST_RX_PAYLOAD_SIZE + 2];
+static unsigned char hostRxLength = 0;
+
+void HostInitialize(void) {
+    hostRxLength = 0;
+    UART_Initialize(
+            HOST_UART_INDEX,
+            HOST_BAUD_CODE,
+            UART_8BIT_MODE,
+            UART_INTERRUPTS_LOW_PRI
+    );
+}
+
+// TRUE when HostSendPacket would queue a packet of this payload length
+unsigned char HostCanSend(unsigned char length) {
+    // HighIsr owns the FIFO while bridging
+    return !BridgeActive() && FIFO_SIZE - FifoCount(&buffers[HOST_TX_FIFO]) >= (unsigned int)length + HOST_PACKET_OVERHEAD;
+}
+
+//===============================================================================
+//	Description:	Queues one complete packet into HOST_TX_FIFO and starts the
+//					UART2 transmit engine. Packets are never split: if the FIFO
+//					cannot take the whole packet nothing is queued.
+//
+//	Params:			TYPE			UCHAR		Packet type
+//					PAYLOAD			UCHAR*		Packet payload
+//					LENGTH			UCHAR		Payload length
+//
+//	Returns:			TRUE if queued, FALSE if the FIFO was too full or the
+//						bridge is running
+//===============================================================================
+unsigned char HostSendPacket(unsigned char type, const unsigned char* payload, unsigned char length) {
+    buffer16* fifo = &buffers[HOST_TX_FIFO];
+    unsigned short crc;
+
+    if (!HostCanSend(length)) {
+        return FALSE;
+    }
+
+    crc = crc_update(GALAXY_CRC_INITIAL, type);
+    crc = crc_update(crc, length);
+    FifoEnqueue(fifo, HOST_SYNC);
+    FifoEnqueue(fifo, type);
+    FifoEnqueue(fifo, length);
+    for (unsigned char x=0; x < length; x++) {
+        crc = crc_update(crc, payload[x]);
+        FifoEnqueue(fifo, payload[x]);
+    }
+    FifoEnqueue(fifo, crc >> 8);
+    FifoEnqueue(fifo, crc & 0xFF);
+
+    UART_StartTransmit(HOST_UART_INDEX);
+    return TRUE;
+}
+
+static void HostDispatch(unsigned char type, const unsigned char* payload, unsigned char length) {
+    unsigned char ack[2];
+
+    ack[0] = type;
+    switch (type) {
+        case HOST_COMMAND_TRIGGER_SET:
+            ack[1] = TriggerHostSet(payload, length);
+            break;
+        case HOST_COMMAND_TRIGGER_CLEAR:
+            ack[1] = TriggerHostClear(payload, length);
+            break;
+        case HOST_COMMAND_FILTER_SET:
+            ack[1] = FilterHostSet(payload, length);
+            break;
+        case HOST_COMMAND_STATS:
+            ack[1] = StatsHostCommand(payload, length);
+            break;
+        case HOST_COMMAND_REPLAY_START:
+            ack[1] = ReplayHostStart(payload, length);
+            break;
+        case HOST_COMMAND_REPLAY_DATA:
+            ack[1] = ReplayHostData(payload, length);
+            break;
+        case HOST_COMMAND_REPLAY_STOP:
+            ack[1] = ReplayHostStop(payload, length);
+            break;
+        case HOST_COMMAND_BUS_CONFIG:
+            ack[1] = BusConfigHostCommand(payload, length);
+            break;
+        case HOST_COMMAND_BRIDGE:
+            ack[1] = BridgeHostCommand(payload, length);
+            break;
+        case HOST_COMMAND_PROFILE:
+            ack[1] = ProfileHostCommand(payload, length);
+            break;
+        default:
+            ack[1] = HOST_STATUS_UNKNOWN;
+            break;
+    }
+    HostSendPacket(HOST_PACKET_ACK, ack, sizeof(ack));
+}
+
+//===============================================================================
+//	Description:	Assembles command packets from HOST_RX_FIFO and runs them.
+//					Bytes that cannot start a packet are skipped, and a bad
+//					length or CRC drops the packet, so the parser resyncs on
+//					the next HOST_SYNC. Call from the main loop.
+//
+//	Params:			NONE
+//
+//	Returns:			NONE
+//===============================================================================
+void HostService(void) {
+    while (!IsFifoEmpty(&buffers[HOST_RX_FIFO])) {
+        unsigned int data = FifoDequeue(&buffers[HOST_RX_FIFO]);
+        unsigned char payloadLength;
+        unsigned short crc;
+
+        if (data & GALAXY_FAULT_MASK) {
+            hostRxLength = 0;
+            continue;
+        }
+        if (hostRxLength == 0 && data != HOST_SYNC) {
+            continue;
+        }
+        hostRx[hostRxLength++] = (unsigned char)data;
+        if (hostRxLength == 3 && hostRx[2] > HOST_RX_PAYLOAD_SIZE) {
+            hostRxLength = 0;
+            continue;
+        }
+        if (hostRxLength < 3) {
+            continue;
+        }
+        payloadLength = hostRx[2];
+        if (hostRxLength != payloadLength + HOST_PACKET_OVERHEAD) {
+            continue;
+        }
+
+        hostRxLength = 0;
+        crc = GALAXY_CRC_INITIAL;
+        for (unsigned char x=1; x < payloadLength + 3; x++) {
+            crc = crc_update(crc, hostRx[x]);
+        }
+        if (hostRx[payloadLength + 3] == (crc >> 8) && hostRx[payloadLength + 4] == (crc & 0xFF)) {
+            HostDispatch(hostRx[1], &hostRx[3], payloadLength);
+        }
+    }
+}
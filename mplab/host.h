@@ -0,0 +1,64 @@
+/* 
+ * File:   host.h
+ *
+ * Packet link to the host PC over UART2 at HOST_BAUD, 8N1. Every packet,
+ * in either direction, is
+ *
+ *     HOST_SYNC, type, length, payload[length], CRC high, CRC low
+ *
+ * where the CRC is the Galaxy CRC-16 over type, length and payload. Each
+ * command from the host is answered with a HOST_PACKET_ACK carrying the
+ * command type and a status byte.
+ */
+
+#ifndef HOST_H
+#define	HOST_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#define HOST_UART_INDEX             UART2_INDEX
+#define HOST_BAUD                   UART_BAUD_460800
+#define HOST_BAUD_CODE              UART_BAUD_CODE_460800
+#define HOST_SYNC                   0xA5
+#define HOST_PACKET_OVERHEAD        5
+
+#define HOST_RX_PAYLOAD_SIZE        72
+
+// Packet types, device to host
+#define HOST_PACKET_CAPTURE         0x01
+#define HOST_PACKET_ACK             0x02
+#define HOST_PACKET_STATS           0x03    // See stats.h
+#define HOST_PACKET_STATS_ADDRESSES 0x04
+#define HOST_PACKET_REPLAY_CREDIT   0x05    // See replay.h
+#define HOST_PACKET_BUS_CONFIG      0x06    // See busconfig.h
+#define HOST_PACKET_PROFILE         0x07    // See profile.h
+
+// Packet types, host to device
+#define HOST_COMMAND_TRIGGER_SET    0x81
+#define HOST_COMMAND_TRIGGER_CLEAR  0x82
+#define HOST_COMMAND_FILTER_SET     0x83
+#define HOST_COMMAND_STATS          0x84
+#define HOST_COMMAND_REPLAY_START   0x85
+#define HOST_COMMAND_REPLAY_DATA    0x86
+#define HOST_COMMAND_REPLAY_STOP    0x87
+#define HOST_COMMAND_BUS_CONFIG     0x88
+#define HOST_COMMAND_BRIDGE         0x89    // See bridge.h
+#define HOST_COMMAND_PROFILE        0x8A
+
+// Acknowledge status, commands add their own codes above these
+#define HOST_STATUS_OK              0x00
+#define HOST_STATUS_UNKNOWN         0xFF
+
+void HostInitialize(void);
+unsigned char HostCanSend(unsigned char length);
+unsigned char HostSendPacket(unsigned char type, const unsigned char* payload, unsigned char length);
+void HostService(void);
+
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* HOST_H */
@@ -4,11 +4,25 @@
  */
 
 #include "app.h"
+#include <stddef.h>
 #include <xc.h>
 #include "osc.h"
-#include "uart.h"
 #include "fifo.h"
+#include "uart.h"
 #include "galaxy.h"
+#include "tick.h"
+#include "timestamp.h"
+#include "poll.h"
+#include "host.h"
+#include "capture.h"
+#include "trigger.h"
+#include "filter.h"
+#include "stats.h"
+#include "replay.h"
+#include "busconfig.h"
+#include "bridge.h"
+#include "scheduler.h"
+#include "profile.h"
 
 // PIC18LF26K22 Configuration Bit Settings
 // 'C' source line config statements
@@ -77,191 +91,238 @@
 // Use project enums instead of #define for ON and OFF.
 
 buffer16 buffers[FIFO_COUNT];
-galaxyBuffer galaxyCommands[GALAXY_COMMAND_COUNT];
-unsigned int digitalOutHyst[DIGITAL_OUT_WORD_COUNT];
+volatile unsigned int rxStamps[FIFO_SIZE];      // DEVICE_RX_FIFO word timestamps, low halves
+galaxyDecoder decoder;
 unsigned int led_green_delay = 0;
 unsigned int led_red_delay = 0;
 unsigned char addressDatagramCount = 0;
+volatile unsigned int rxOverrunsAvoided = 0;    // Second word already waiting in the UART
 
 // High priority interrupt
 void __interrupt(high_priority) HighIsr (void) {
-    if (TMR1IE && TMR1IF)
+    PROFILE_HIGH_ENTER();
+    if (PIE5bits.TMR4IE && PIR5bits.TMR4IF)
+    {
+        UART_TurnaroundInterrupt();
+    }
+    if (PIE1bits.CCP1IE && PIR1bits.CCP1IF)
+    {
+        ReplayCompareInterrupt();
+    }
+    if (PIE1bits.TX1IE && PIR1bits.TX1IF)
+    {
+        BridgeTransmitInterrupt();
+        UART_TransmitInterrupt(UART1_INDEX, &buffers[DEVICE_TX_FIFO]);
+    }
+    if (PIE1bits.RC1IE && PIR1bits.RC1IF)
+    {
+        // Drain the two-deep receive FIFO so the UART never overruns. The
+        // polled path read one word per main-loop pass, so every time a
+        // second word is already waiting here it was one character time
+        // away from an overrun. Stamps mark when the word was serviced.
+        unsigned int stamp;
+        PROFILE_RECEIVE();
+        stamp = (unsigned int)TimestampNow();
+        unsigned int data = GetChar9(UART1_INDEX);
+        FilterReceiveInterrupt(data);
+        FifoEnqueueStamped(&buffers[DEVICE_RX_FIFO], rxStamps, data, stamp);
+        BridgeDeviceInterrupt(data);
+        if (PIR1bits.RC1IF) {
+            rxOverrunsAvoided++;
+            data = GetChar9(UART1_INDEX);
+            FilterReceiveInterrupt(data);
+            FifoEnqueueStamped(&buffers[DEVICE_RX_FIFO], rxStamps, data, stamp);
+            BridgeDeviceInterrupt(data);
+        }
+    }
+    if (PIE1bits.TMR1IE && PIR1bits.TMR1IF)
     {
-        TMR1IF=0;
+        TimestampInterrupt();
     }
+    PROFILE_HIGH_EXIT();
 }
 
 // Low priority interrupt
 void __interrupt(low_priority) LowIsr(void) {
-    if(INTCONbits.T0IF && INTCONbits.T0IE)  // If Timer flag is set & Interrupt is enabled
+    PROFILE_LOW_ENTER();
+    if (PIE3bits.RC2IE && PIR3bits.RC2IF)
     {
-        // Transmit a char
-        if (IsTransmitterReady(UART1_INDEX) && TXSTA1bits.TRMT == 1 && !IsFifoEmpty(&buffers[DEVICE_TX_FIFO])) {
-            unsigned int data = FifoDequeue(&buffers[DEVICE_TX_FIFO]);
-            PutChar9Default(data);
-            led_red_delay = 2500;
+        unsigned int data = GetChar9(HOST_UART_INDEX);
+        if (!BridgeHostInterrupt(data)) {
+            FifoEnqueue(&buffers[HOST_RX_FIFO], data);
         }
+    }
+    if (PIE3bits.TX2IE && PIR3bits.TX2IF)
+    {
+        UART_TransmitInterrupt(HOST_UART_INDEX, &buffers[HOST_TX_FIFO]);
+    }
+    if (PIE1bits.TMR2IE && PIR1bits.TMR2IF)
+    {
+        TickInterrupt();
+    }
+    PROFILE_LOW_EXIT();
+}
+
+static unsigned char ReceiveReady(void) {
+    return !IsFifoEmpty(&buffers[DEVICE_RX_FIFO]) || GalaxyFramePeek(&decoder);
+}
+
+// TRMT has no interrupt, so the driver release is polled once the last
+// word is in the shift register. Not during the turnaround, whose
+// TMR4IF wakes the core, nor during a replay, which holds the driver.
+static unsigned char DeviceTransmitReady(void) {
+    return PIN_UART1_TX_ENABLE_LATCH == UART1_TX_LATCH_ACTIVE && !PIE1bits.TX1IE && !PIE5bits.TMR4IE
+            && !ReplayActive();
+}
 
-        unsigned int resetValue = 0xFFFF - 120;
-        TMR0H = (resetValue >> 8);
-        TMR0L = (resetValue & 0xFF);
-        INTCONbits.T0IF = 0;            // Clear the interrupt flag 
+static void DeviceTransmitRelease(void) {
+    // The bridge starts UART1 transmits from LowIsr, which must not land
+    // between the idle check and the driver release
+    INTCONbits.GIEL = 0;
+    UART_TransmitService(UART1_INDEX);
+    INTCONbits.GIEL = 1;
+}
+
+static unsigned char HostReceiveReady(void) {
+    return !IsFifoEmpty(&buffers[HOST_RX_FIFO]);
+}
+
+static void LedService(void) {
+    if (led_red_delay > 0) {
+        PIN_LED_RED_TRIS = 0;
+        PIN_LED_RED_LATCH = 0;
+        led_red_delay--;
+    } else {
+        PIN_LED_RED_LATCH = 1;
     }
+    if (led_green_delay > 0) {
+        PIN_LED_GREEN_TRIS = 0;
+        PIN_LED_GREEN_LATCH = 0;
+        led_green_delay--;
+    } else {
+        PIN_LED_GREEN_TRIS = 1;
+    }
+}
+
+static void LedBlink(void) {
+    PIN_LED_BLUE_TRIS = 0;
+    PIN_LED_BLUE_LATCH = !PIN_LED_BLUE_LATCH;
 }
 
+// Run order. BridgeService must follow HostService so nothing is queued
+// between the bridge acknowledge and the switch.
+static schedTask appTasks[] = {
+    { TinyDelay,                ReceiveReady,           0, 0 },
+    { DeviceTransmitRelease,    DeviceTransmitReady,    0, 0 },
+    { PollService,              NULL,                   1, 0 },
+    { ReplayService,            ReplayPending,          0, 0 },
+    { CaptureService,           NULL,                   1, 0 },
+    { HostService,              HostReceiveReady,       0, 0 },
+    { BridgeService,            BridgePending,          0, 0 },
+    { StatsService,             NULL,                   1, 0 },
+    { BusConfigService,         BusConfigPending,       0, 0 },
+    { ProfileService,           ProfilePending,         0, 0 },
+    { LedService,               NULL,                   1, 0 },
+    { LedBlink,                 NULL,                   LED_BLINK_TICKS, 0 },
+};
+#define APP_TASK_COUNT  (sizeof(appTasks) / sizeof(appTasks[0]))
+
 void main(void) {
+    AppInitialize();
+    while (1) {
+        AppService();
+    }
+}
 
-    unsigned long l = 0;
-    unsigned long m = 0;
-    unsigned int data;
-    unsigned char commandNumber = 0;
-    unsigned int i = 0;
-    unsigned int j = 0;
-    unsigned char tf = 0;
-    unsigned char c = 0;
-    unsigned short crc;
-    unsigned char galaxyCommandCount = 0;
-        
+// Everything up to the main loop. Split out so the host simulator in sim/
+// can run the firmware one loop pass at a time.
+void AppInitialize(void) {
     ANSELA = 0;
     ANSELB = 0;
     ANSELC = 0;
 
     ConfigureOscillator();
-    UART_Initialize(
-            UART1_INDEX,
-            UART_BAUD_19200,
-            UART_9BIT_MODE,
-            UART_INTERRUPTS_DISABLED
-    );
-//    UART_Initialize(
-//            UART2_INDEX,
-//            UART_BAUD_115200,
-//            UART_8BIT_MODE,
-//            UART_INTERRUPTS_DISABLED
-//    );
+
+    // FIFOs must be ready before the receive interrupt is enabled
+    for (unsigned char x=0; x < FIFO_COUNT; x++) {
+        FifoInitialize(&buffers[x]);
+    }
+    GalaxyDecoderInitialize(&decoder);
+
+    BusConfigInitialize();
+    HostInitialize();
     EnableTransceiverRX(UART1_INDEX);
-//    EnableTransceiverRX(UART2_INDEX);
 
     // Initialize Digital Sequencer
-    for (unsigned char x=0; x < 4; x++) {
-        digitalOutHyst[x] = 0x0000;
-    }
+    DigitalBreakoutInitialize();
+    TriggerInitialize();
+    FilterInitialize();
         
-    // DISCONNECT
-    c = 0;
-    galaxyCommands[c].word_count = 0;
-    galaxyCommands[c].buffer[galaxyCommands[c].word_count++] = 0x01FF;
-    galaxyCommands[c].buffer[galaxyCommands[c].word_count++] = 0x0007;
-    galaxyCommands[c].buffer[galaxyCommands[c].word_count++] = 0x0057;
-    galaxyCommands[c].buffer[galaxyCommands[c].word_count++] = 0x0004;
-    galaxyCommands[c].buffer[galaxyCommands[c].word_count++] = 0x0001;
-    galaxyCommands[c].crc = compute_crc(&galaxyCommands[c].buffer[0], galaxyCommands[c].word_count);
-    galaxyCommandCount++;
-
-    // CHOOSE SLOT
-    c = 1;
-    galaxyCommands[c].word_count = 0;
-    galaxyCommands[c].buffer[galaxyCommands[c].word_count++] = 0x01FF;
-    galaxyCommands[c].buffer[galaxyCommands[c].word_count++] = 0x0006;
-    galaxyCommands[c].buffer[galaxyCommands[c].word_count++] = 0x0043;
-    galaxyCommands[c].buffer[galaxyCommands[c].word_count++] = (GALAXY_MAX_SLOTS - 1);
-    galaxyCommands[c].crc = compute_crc(&galaxyCommands[c].buffer[0], galaxyCommands[c].word_count);
-    galaxyCommandCount++;
-
-    // POLL SLOTS
-    c = 2;
-    for (unsigned char slot=0; slot <= GALAXY_MAX_SLOTS; slot++) {
-        galaxyCommands[c].word_count = 0;
-        galaxyCommands[c].buffer[galaxyCommands[c].word_count++] = 0x01FF;
-        galaxyCommands[c].buffer[galaxyCommands[c].word_count++] = 0x0006;
-        galaxyCommands[c].buffer[galaxyCommands[c].word_count++] = 0x0050;
-        galaxyCommands[c].buffer[galaxyCommands[c].word_count++] = slot;
-        galaxyCommands[c].crc = compute_crc(&galaxyCommands[c].buffer[0], galaxyCommands[c].word_count);
-        c++;
-        galaxyCommandCount++;
-    }
-
-    for (unsigned char x=0; x <= FIFO_COUNT; x++) {
-        FifoInitialize(&buffers[x]);
-    };
-
-//    T1CON = 0x1;               //Configure Timer1 interrupt
-//    PIE1bits.TMR1IE = 1;           
-//    INTCONbits.PEIE = 1;
-//    RCONbits.IPEN=0x01;
-//    IPR1bits.TMR1IP=0x01;            // TMR1 high priority ,TMR1 Overflow Interrupt Priority bit
-//    INTCONbits.GIE = 1;
-//    PIR1bits.TMR1IF = 0;
-
-    T0CONbits.TMR0ON = 0;                   // Off
-    T0CONbits.T08BIT = 0;                   // 16 bit
-    T0CONbits.T0CS = 0;                     // Clocked by instruction cycle (FOSC/4)
-    T0CONbits.T0SE = 0;                     // Low to high transition
-    T0CONbits.PSA = 0;                      // Use prescaler
-    T0CON = (T0CON & 0xF8) | 0x07;          // 1:256 prescaler
-    INTCON2bits.TMR0IP=0x00;                // Use low priority ISR
-    INTCONbits.TMR0IE = 1;                  // Enable interrupt on TMR0 overflow
-    T0CONbits.TMR0ON = 1;                   // Enable the timer
+    TimestampInitialize();
+    TickInitialize();
+    PollInitialize();
+    CaptureInitialize();
+    StatsInitialize();
+    ReplayInitialize();
+    BridgeInitialize();
+    SchedInitialize(appTasks, APP_TASK_COUNT);
+    ProfileInitialize(APP_TASK_COUNT);
 
     RCONbits.IPEN = 1;                      // Enable interrupt priorities
     INTCONbits.GIEL = 1;                    // Enable Global Low Priority Interrupts
     INTCONbits.GIE = 1;                     // Enable interrupts
 
-    while (1) {
-        // LED Control
-        if (l % 32768 == 0) {
-            PIN_LED_BLUE_TRIS = 0;
-            if (PIN_LED_BLUE_LATCH == 1) {
-                PIN_LED_BLUE_LATCH = 0;
-            } else {
-                PIN_LED_BLUE_LATCH = 1;
-            }
-        }
-        if (led_red_delay > 0) {
-            PIN_LED_RED_TRIS = 0;
-            PIN_LED_RED_LATCH = 0;
-            led_red_delay--;
-        } else {
-            PIN_LED_RED_LATCH = 1;
-        }
-        if (led_green_delay > 0) {
-            PIN_LED_GREEN_TRIS = 0;
-            PIN_LED_GREEN_LATCH = 0;
-            led_green_delay--;
-        } else {
-            PIN_LED_GREEN_TRIS = 1;
+#if POLL_AT_STARTUP
+    PollStart();
+#endif
+#if CAPTURE_AT_STARTUP
+    CaptureEnable(TRUE);
+#endif
+}
+
+// One pass of the main loop
+void AppService(void) {
+    SchedService();
+}
+
+void TinyDelay() {
+    // Process chars captured by the receive ISR. Stamps come back whole
+    // unless a word sat here for a Timer1 lap, a 32 ms main loop stall.
+    while (!IsFifoEmpty(&buffers[DEVICE_RX_FIFO])) {
+        unsigned int low;
+        unsigned int data = FifoDequeueStamped(&buffers[DEVICE_RX_FIFO], rxStamps, &low);
+        unsigned long stamp = TimestampExtend(low);
+        unsigned char count = FilterWord(data, stamp);
+        for (unsigned char k=0; k < count; k++) {
+            DigitalBreakout(filterOutput[k].word);
+            CaptureWord(filterOutput[k].word, filterOutput[k].stamp);
         }
+        StatsWord(data, GalaxyDecode(&decoder, data, stamp));
+        led_green_delay = LED_RX_TICKS;
+    }
 
-        TinyDelay();
-
-//        if (l == 700000) {
-//            for (unsigned char k=0; k < galaxyCommands[commandNumber].word_count; k++) {
-//                FifoEnqueue(&buffers[DEVICE_TX_FIFO], galaxyCommands[commandNumber].buffer[k]);
-//            }    
-//            FifoEnqueue(&buffers[DEVICE_TX_FIFO], galaxyCommands[commandNumber].crc >> 8);
-//            FifoEnqueue(&buffers[DEVICE_TX_FIFO], galaxyCommands[commandNumber].crc & 0xFF);
-//            
-//            commandNumber++;
-//            if (commandNumber > galaxyCommandCount) {
-//                commandNumber = 2;
-//            }
-//            
-//            l = 0;
-//        }
-
-        l++;
+    // Validated frames
+    galaxyBuffer* frame;
+    while ((frame = GalaxyFramePeek(&decoder))) {
+        StatsFrame(frame);
+        PollFrameReceived(frame);
+        GalaxyFrameRelease(&decoder);
     }
- 
 }
 
-void TinyDelay() {
-    // Receive a char
-    if (IsRxDataAvailable(UART1_INDEX) && !IsFifoFull(&buffers[DEVICE_RX_FIFO])) {
-        unsigned int data = GetChar9(UART1_INDEX);
-        //FifoEnqueue(&buffers[DEVICE_RX_FIFO], data);
-        DigitalBreakout(data);
-        led_green_delay = 5000;
+unsigned char QueueDeviceCommand(unsigned char command) {
+    const galaxyCommand* frame = &galaxyCommands[command];
+    unsigned char queued;
+
+    // Table holds the complete frame, CRC included
+    queued = FifoEnqueue(&buffers[DEVICE_TX_FIFO], GALAXY_ADDRESS_FLAG | frame->words[0]);
+    for (unsigned char k=1; k < frame->word_count; k++) {
+        queued &= FifoEnqueue(&buffers[DEVICE_TX_FIFO], frame->words[k]);
     }
+    UART_StartTransmit(UART1_INDEX);
+
+    led_red_delay = LED_TX_TICKS;
+    return queued;
 }
 
 unsigned long ToAscii(unsigned long in) {
@@ -297,118 +358,48 @@ unsigned char NibbleToAscii(unsigned char in) {
     }
 }
 
-void DigitalBreakout(unsigned int newData) {
-    // Shift hysteresis words
-    for (unsigned char x=0; x < (DIGITAL_OUT_WORD_COUNT - 1); x++) {
-        digitalOutHyst[x] = 0x1FF & digitalOutHyst[x+1];
-    }
-    // Store new data at end of shift register
-    digitalOutHyst[DIGITAL_OUT_WORD_COUNT - 1] = 0x1FF & newData;
-    
-    // Output trigger signal when matching sequential pattern occurs
-    PIN_DIG_OUT_12_TRIS = 0;
-    if (digitalOutHyst[0] == 0x100 && digitalOutHyst[1] == 0x017 && digitalOutHyst[2] == 0x072) {
-        PIN_DIG_OUT_12_LATCH = 1;
-    } else {
-        PIN_DIG_OUT_12_LATCH = 0;
-    }
-
-    unsigned int output = newData;
-    unsigned int mask = 0x0800;                 // No data available
-    PIN_DIG_OUT_11_TRIS = 0;
-    if ((output & mask) == mask) {
-        PIN_DIG_OUT_11_LATCH = 1;
-    } else {
-        PIN_DIG_OUT_11_LATCH = 0;
-    }
-    
-    mask = mask >> 1;                           // Framing error
-    PIN_DIG_OUT_10_TRIS = 0;
-    if ((output & mask) == mask) {
-        PIN_DIG_OUT_10_LATCH = 1;
-    } else {
-        PIN_DIG_OUT_10_LATCH = 0;
-    }
-    
-    mask = mask >> 1;                           // 9th bit
-    PIN_DIG_OUT_9_TRIS = 0;
-    if ((output & mask) == mask) {
-        PIN_DIG_OUT_9_LATCH = 1;
-    } else {
-        PIN_DIG_OUT_9_LATCH = 0;
-    }
-    
-//    unsigned int mask = 0x0200;
-    mask = mask >> 1;
-    PIN_DIG_OUT_8_TRIS = 0;
-    if ((output & mask) == mask) {
-        PIN_DIG_OUT_8_LATCH = 1;
-    } else {
-        PIN_DIG_OUT_8_LATCH = 0;
-    }
-    
-    mask = mask >> 1;
-    PIN_DIG_OUT_7_TRIS = 0;
-    if ((output & mask) == mask) {
-        PIN_DIG_OUT_7_LATCH = 1;
-    } else {
-        PIN_DIG_OUT_7_LATCH = 0;
-    }
-    
-    mask = mask >> 1;
-    PIN_DIG_OUT_6_TRIS = 0;
-    if ((output & mask) == mask) {
-        PIN_DIG_OUT_6_LATCH = 1;
-    } else {
-        PIN_DIG_OUT_6_LATCH = 0;
-    }
-    
-    mask = mask >> 1;
-    PIN_DIG_OUT_5_TRIS = 0;
-    if ((output & mask) == mask) {
-        PIN_DIG_OUT_5_LATCH = 1;
-    } else {
-        PIN_DIG_OUT_5_LATCH = 0;
-    }
-    
-    mask = mask >> 1;
-    PIN_DIG_OUT_4_TRIS = 0;
-    if ((output & mask) == mask) {
-        PIN_DIG_OUT_4_LATCH = 1;
-    } else {
-        PIN_DIG_OUT_4_LATCH = 0;
-    }
-    
-    mask = mask >> 1;
-    PIN_DIG_OUT_3_TRIS = 0;
-    if ((output & mask) == mask) {
-        PIN_DIG_OUT_3_LATCH = 1;
-    } else {
-        PIN_DIG_OUT_3_LATCH = 0;
-    }
-    
-    mask = mask >> 1;
-    PIN_DIG_OUT_2_TRIS = 0;
-    if ((output & mask) == mask) {
-        PIN_DIG_OUT_2_LATCH = 1;
-    } else {
-        PIN_DIG_OUT_2_LATCH = 0;
-    }
-    
-    mask = mask >> 1;
-    PIN_DIG_OUT_1_TRIS = 0;
-    if ((output & mask) == mask) {
-        PIN_DIG_OUT_1_LATCH = 1;
-    } else {
-        PIN_DIG_OUT_1_LATCH = 0;
-    }
-    
-    mask = mask >> 1;
-    PIN_DIG_OUT_0_TRIS = 0;
-    if ((output & mask) == mask) {
-        PIN_DIG_OUT_0_LATCH = 1;
-    } else {
-        PIN_DIG_OUT_0_LATCH = 0;
-    }
+// Word bits 8..11 split across PORTC and PORTB, see app.h
+static const unsigned char breakoutHighPortC[16] = {
+    0x00, 0x10, 0x20, 0x30, 0x00, 0x10, 0x20, 0x30,
+    0x00, 0x10, 0x20, 0x30, 0x00, 0x10, 0x20, 0x30,
+};
+static const unsigned char breakoutHighPortB[16] = {
+    0x00, 0x00, 0x00, 0x00, 0x01, 0x01, 0x01, 0x01,
+    0x02, 0x02, 0x02, 0x02, 0x03, 0x03, 0x03, 0x03,
+};
+
+// Breakout pins are outputs for good, so TRIS is set once here
+void DigitalBreakoutInitialize(void) {
+    TRISA = TRISA & ~DIG_OUT_PORTA_MASK;
+    TRISB = TRISB & ~DIG_OUT_PORTB_MASK;
+    TRISC = TRISC & ~DIG_OUT_PORTC_MASK;
 }
 
+//===============================================================================
+//	Description:	Drives the word onto DIG_OUT_0..11 and the trigger pins
+//					onto DIG_OUT_12..14, with one masked write per port so
+//					all pins of a port change on the same instruction.
+//					Each write reads back the whole latch, and the ISRs
+//					drive other pins of the same ports (the RS-485 driver
+//					enable on RA5, the profile pin on RB4), so the writes
+//					run with GIEH clear.
+//
+//	Params:			NEWDATA			UINT		Received word, fault bits included
+//
+//	Returns:			NONE
+//===============================================================================
+void DigitalBreakout(unsigned int newData) {
+    unsigned char pins = TriggerUpdate(newData);
+    unsigned char low = (unsigned char)newData;
+    unsigned char high = (unsigned char)(newData >> 8) & 0x0F;
+    unsigned char portA = low & 0x0F;
+    unsigned char portC = (low >> 4) | breakoutHighPortC[high];
+    unsigned char portB = breakoutHighPortB[high] | (pins << DIG_OUT_TRIGGER_SHIFT);
+    unsigned char interrupts = INTCONbits.GIEH;
+
+    INTCONbits.GIEH = 0;
+    LATA = (LATA & ~DIG_OUT_PORTA_MASK) | portA;
+    LATC = (LATC & ~DIG_OUT_PORTC_MASK) | portC;
+    LATB = (LATB & ~DIG_OUT_PORTB_MASK) | portB;
+    INTCONbits.GIEH = interrupts;
+}
@@ -0,0 +1,120 @@
+#include "app.h"
+#include "galaxy.h"
+#include "tick.h"
+#include "timestamp.h"
+#include "fifo.h"
+#include "uart.h"
+#include "poll.h"
+
+pollSlotStats pollStats[GALAXY_MAX_SLOTS];
+
+static unsigned char pollState = POLL_STATE_STOPPED;
+static unsigned char pollSlot = 0;
+static unsigned int pollGapTicks = POLL_GAP_TICKS_DEFAULT;
+static unsigned int pollWindowTicks = POLL_WINDOW_TICKS_DEFAULT;
+static unsigned int pollStateTick = 0;      // Tick the current state began
+static unsigned long pollSentStamp = 0;     // End of the poll on the wire
+
+void PollInitialize(void) {
+    pollState = POLL_STATE_STOPPED;
+    pollSlot = 0;
+    for (unsigned char x=0; x < GALAXY_MAX_SLOTS; x++) {
+        pollStats[x].polls = 0;
+        pollStats[x].responses = 0;
+        pollStats[x].timeouts = 0;
+        pollStats[x].lastLatency = 0;
+        pollStats[x].maxLatency = 0;
+    }
+}
+
+void PollConfigure(unsigned int gapTicks, unsigned int windowTicks) {
+    pollGapTicks = gapTicks;
+    pollWindowTicks = windowTicks;
+}
+
+void PollStart(void) {
+    pollSlot = 0;
+    pollStateTick = TickNow();
+    pollState = POLL_STATE_GAP;
+}
+
+void PollStop(void) {
+    pollState = POLL_STATE_STOPPED;
+}
+
+static void PollNextSlot(void) {
+    pollSlot++;
+    if (pollSlot >= GALAXY_MAX_SLOTS) {
+        pollSlot = 0;
+    }
+    pollStateTick = TickNow();
+    pollState = POLL_STATE_GAP;
+}
+
+// Call from the main loop
+void PollService(void) {
+    unsigned int elapsed = TickNow() - pollStateTick;
+
+    switch (pollState) {
+        case POLL_STATE_GAP:
+            if (elapsed >= pollGapTicks) {
+                QueueDeviceCommand(GALAXY_CMD_POLL_SLOT + pollSlot);
+                pollStats[pollSlot].polls++;
+                pollState = POLL_STATE_SENDING;
+            }
+            break;
+
+        case POLL_STATE_SENDING:
+            // Response window opens once the driver is released
+            if (UART_TransmitService(UART1_INDEX)) {
+                pollSentStamp = TimestampNow();
+                pollStateTick = TickNow();
+                pollState = POLL_STATE_WAIT;
+            }
+            break;
+
+        case POLL_STATE_WAIT:
+            if (elapsed >= pollWindowTicks) {
+                pollStats[pollSlot].timeouts++;
+                PollNextSlot();
+            }
+            break;
+
+        default:
+            break;
+    }
+}
+
+// True when the frame is the receiver hearing our own poll
+static unsigned char IsPollEcho(galaxyBuffer* frame) {
+    const galaxyCommand* command = &galaxyCommands[GALAXY_CMD_POLL_SLOT + pollSlot];
+    unsigned char count = command->word_count - 2;
+    unsigned int crc = ((unsigned int)command->words[count] << 8) | command->words[count + 1];
+
+    return (frame->word_count == count && frame->crc == crc);
+}
+
+// Call for each validated frame from the decoder
+void PollFrameReceived(galaxyBuffer* frame) {
+    unsigned long latency;
+
+    if (pollState != POLL_STATE_SENDING && pollState != POLL_STATE_WAIT) {
+        return;
+    }
+    if (IsPollEcho(frame)) {
+        // Our own stop bit as heard by the receiver beats the main loop's view
+        pollSentStamp = frame->end_timestamp;
+        return;
+    }
+    if (pollState != POLL_STATE_WAIT) {
+        return;
+    }
+
+    latency = frame->timestamp - pollSentStamp;
+    pollStats[pollSlot].responses++;
+    pollStats[pollSlot].lastLatency = latency;
+    if (latency > pollStats[pollSlot].maxLatency) {
+        pollStats[pollSlot].maxLatency = latency;
+    }
+    PollNextSlot();
+}
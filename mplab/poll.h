@@ -0,0 +1,46 @@
+/* 
+ * File:   poll.h
+ *
+ * Master polling engine. Sends POLL_SLOT commands on the system tick with
+ * a configurable gap and records each slot's response latency.
+ */
+
+#ifndef POLL_H
+#define	POLL_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#define POLL_GAP_TICKS_DEFAULT      5       // Idle ticks before each poll
+#define POLL_WINDOW_TICKS_DEFAULT   10      // Ticks to wait for a response
+
+// Poller states
+#define POLL_STATE_STOPPED          0
+#define POLL_STATE_GAP              1       // Inter-frame gap
+#define POLL_STATE_SENDING          2       // Poll frame in the transmit engine
+#define POLL_STATE_WAIT             3       // Response window open
+
+typedef struct {
+    unsigned int polls;
+    unsigned int responses;
+    unsigned int timeouts;
+    unsigned long lastLatency;              // Poll stop bit to response, timestamp units
+    unsigned long maxLatency;
+} pollSlotStats;
+
+extern pollSlotStats pollStats[GALAXY_MAX_SLOTS];
+
+void PollInitialize(void);
+void PollConfigure(unsigned int gapTicks, unsigned int windowTicks);
+void PollStart(void);
+void PollStop(void);
+void PollService(void);
+void PollFrameReceived(galaxyBuffer* frame);
+
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* POLL_H */
@@ -0,0 +1,288 @@
+#include <xc.h>
+#include "app.h"
+#include "timestamp.h"
+#include "host.h"
+#include "scheduler.h"
+#include "profile.h"
+
+typedef struct {
+    unsigned long time;                     // Free running, reports take differences
+    unsigned long entries;
+    unsigned int longest;
+} profileIsr;
+
+typedef struct {
+    unsigned long time;
+    unsigned int longest;
+} profileTask;
+
+// Each written by its own ISR only, main() reads them with GIEH clear
+static volatile profileIsr profileHigh;
+static volatile profileIsr profileLow;
+static volatile unsigned int profileLatency = 0;        // TMR1IF to HighIsr entry
+static volatile unsigned int profileReceiveOffset = 0;  // HighIsr entry to RCREG1 read
+static unsigned int profileHighStart;
+static unsigned int profileLowStart;
+static volatile unsigned char profileInLow = FALSE;
+static volatile unsigned int profileLowNested = 0;      // HighIsr time inside this LowIsr entry
+
+static profileTask profileTasks[PROFILE_TASK_MAX];
+static unsigned char profileTaskCount = 0;
+static unsigned int profileTaskStart;
+static unsigned long profileTaskIsrStart;
+static unsigned long profileIdleReported = 0;   // SchedIdleTime() at the window start
+static unsigned long profileResetStamp = 0;
+static profileIsr profileHighReported;
+static profileIsr profileLowReported;
+static unsigned char profileReportPending = FALSE;
+
+// TMR1 through the RD16 latch, the low 16 bits of TimestampNow()
+static unsigned int ProfileClock(void) {
+    unsigned char low = TMR1L;              // Latches TMR1H
+    return ((unsigned int)TMR1H << 8) | low;
+}
+
+// A HighIsr clock read between the two bytes would reload the latch
+static unsigned int ProfileClockMasked(void) {
+    unsigned char interrupts = INTCONbits.GIEH;
+    unsigned int now;
+
+    INTCONbits.GIEH = 0;
+    now = ProfileClock();
+    INTCONbits.GIEH = interrupts;
+    return now;
+}
+
+static void ProfileIsrRecord(volatile profileIsr* isr, unsigned int time) {
+    isr->time += time;
+    isr->entries++;
+    if (time > isr->longest) {
+        isr->longest = time;
+    }
+}
+
+void ProfileInitialize(unsigned char taskCount) {
+    unsigned char interrupts = INTCONbits.GIEH;
+
+    profileTaskCount = (taskCount < PROFILE_TASK_MAX) ? taskCount : PROFILE_TASK_MAX;
+    for (unsigned char x=0; x < PROFILE_TASK_MAX; x++) {
+        profileTasks[x].time = 0;
+        profileTasks[x].longest = 0;
+    }
+    INTCONbits.GIEH = 0;
+    profileHigh.time = profileHigh.entries = 0;
+    profileHigh.longest = 0;
+    profileLow.time = profileLow.entries = 0;
+    profileLow.longest = 0;
+    profileLatency = 0;
+    profileReceiveOffset = 0;
+    profileInLow = FALSE;
+    INTCONbits.GIEH = interrupts;
+    profileHighReported.time = profileHighReported.entries = 0;
+    profileLowReported.time = profileLowReported.entries = 0;
+    profileIdleReported = SchedIdleTime();
+    profileResetStamp = TimestampNow();
+    profileReportPending = FALSE;
+#if PROFILE_ENABLED && PROFILE_PIN
+    PIN_PROFILE_LATCH = 0;
+    PIN_PROFILE_TRIS = 0;
+#endif
+}
+
+//===============================================================================
+//	Description:	First thing in HighIsr. Takes the entry latency from
+//					TMR1 when the timer overflow is one of the sources.
+//
+//	Params:			NONE
+//
+//	Returns:			NONE
+//===============================================================================
+void ProfileHighEnter(void) {
+#if PROFILE_PIN
+    PIN_PROFILE_LATCH = 1;
+#endif
+    profileHighStart = ProfileClock();
+    // TMR1 has counted up from zero since TMR1IF was raised
+    if (PIE1bits.TMR1IE && PIR1bits.TMR1IF && profileHighStart > profileLatency) {
+        profileLatency = profileHighStart;
+    }
+}
+
+// Last thing in HighIsr
+void ProfileHighExit(void) {
+    unsigned int time = ProfileClock() - profileHighStart;
+
+    ProfileIsrRecord(&profileHigh, time);
+    if (profileInLow) {
+        profileLowNested += time;
+    }
+#if PROFILE_PIN
+    PIN_PROFILE_LATCH = profileInLow;
+#endif
+}
+
+// HighIsr, just ahead of the first RCREG1 read
+void ProfileReceive(void) {
+    unsigned int offset = ProfileClock() - profileHighStart;
+
+    if (offset > profileReceiveOffset) {
+        profileReceiveOffset = offset;
+    }
+}
+
+// First thing in LowIsr. A HighIsr landing before profileInLow is set
+// is counted in both, never taken out twice.
+void ProfileLowEnter(void) {
+#if PROFILE_PIN
+    PIN_PROFILE_LATCH = 1;
+#endif
+    profileLowStart = ProfileClockMasked();
+    profileLowNested = 0;
+    profileInLow = TRUE;
+}
+
+// Last thing in LowIsr
+void ProfileLowExit(void) {
+    unsigned int time;
+
+    profileInLow = FALSE;
+    time = ProfileClockMasked() - profileLowStart - profileLowNested;
+    ProfileIsrRecord(&profileLow, time);
+#if PROFILE_PIN
+    PIN_PROFILE_LATCH = 0;
+#endif
+}
+
+// Around each scheduler task run, from main()
+void ProfileTaskBegin(void) {
+    unsigned char interrupts = INTCONbits.GIEH;
+
+    INTCONbits.GIEH = 0;
+    profileTaskStart = ProfileClock();
+    profileTaskIsrStart = profileHigh.time + profileLow.time;
+    INTCONbits.GIEH = interrupts;
+}
+
+//===============================================================================
+//	Description:	Charges the time since ProfileTaskBegin, less the ISR
+//					time inside it, to a task. Runs are assumed shorter
+//					than one Timer1 period, 32 ms.
+//
+//	Params:			INDEX			UCHAR		Task position in the sched table
+//
+//	Returns:			NONE
+//===============================================================================
+void ProfileTaskEnd(unsigned char index) {
+    unsigned char interrupts = INTCONbits.GIEH;
+    unsigned int time;
+    unsigned long isr;
+
+    INTCONbits.GIEH = 0;
+    time = ProfileClock() - profileTaskStart;
+    isr = profileHigh.time + profileLow.time - profileTaskIsrStart;
+    INTCONbits.GIEH = interrupts;
+
+    if (index >= profileTaskCount) {
+        return;
+    }
+    time -= (unsigned int)isr;
+    profileTasks[index].time += time;
+    if (time > profileTasks[index].longest) {
+        profileTasks[index].longest = time;
+    }
+}
+
+static unsigned char* ProfilePut16(unsigned char* p, unsigned int value) {
+    p[0] = (unsigned char)value;
+    p[1] = (unsigned char)(value >> 8);
+    return p + 2;
+}
+
+static unsigned char* ProfilePut32(unsigned char* p, unsigned long value) {
+    p = ProfilePut16(p, (unsigned int)value);
+    return ProfilePut16(p, (unsigned int)(value >> 16));
+}
+
+static unsigned char* ProfilePutIsr(unsigned char* p, const profileIsr* now, const profileIsr* reported) {
+    p = ProfilePut32(p, now->time - reported->time);
+    p = ProfilePut32(p, now->entries - reported->entries);
+    return ProfilePut16(p, now->longest);
+}
+
+//===============================================================================
+//	Description:	Sends the report asked for by HOST_COMMAND_PROFILE and
+//					starts a new window. Retried on later passes while
+//					HOST_TX_FIFO has no room.
+//
+//	Params:			NONE
+//
+//	Returns:			NONE
+//===============================================================================
+void ProfileService(void) {
+    unsigned char payload[PROFILE_PAYLOAD_SIZE(PROFILE_TASK_MAX)];
+    unsigned char* p = payload;
+    unsigned char interrupts = INTCONbits.GIEH;
+    unsigned long now = TimestampNow();
+    unsigned long idle = SchedIdleTime();
+    profileIsr high;
+    profileIsr low;
+    unsigned int latency;
+    unsigned int offset;
+
+    INTCONbits.GIEH = 0;
+    high = profileHigh;
+    low = profileLow;
+    latency = profileLatency;
+    offset = profileReceiveOffset;
+    INTCONbits.GIEH = interrupts;
+
+    p = ProfilePut32(p, now - profileResetStamp);
+    p = ProfilePut32(p, idle - profileIdleReported);
+    p = ProfilePutIsr(p, &high, &profileHighReported);
+    p = ProfilePutIsr(p, &low, &profileLowReported);
+    p = ProfilePut16(p, latency);
+    p = ProfilePut16(p, offset);
+    *p++ = profileTaskCount;
+    for (unsigned char x=0; x < profileTaskCount; x++) {
+        p = ProfilePut32(p, profileTasks[x].time);
+        p = ProfilePut16(p, profileTasks[x].longest);
+    }
+    if (!HostSendPacket(HOST_PACKET_PROFILE, payload, (unsigned char)(p - payload))) {
+        return;
+    }
+    profileReportPending = FALSE;
+
+    // New window. Worst cases reached since the copy above are lost.
+    INTCONbits.GIEH = 0;
+    profileHigh.longest = 0;
+    profileLow.longest = 0;
+    profileLatency = 0;
+    profileReceiveOffset = 0;
+    INTCONbits.GIEH = interrupts;
+    profileHighReported = high;
+    profileLowReported = low;
+    for (unsigned char x=0; x < profileTaskCount; x++) {
+        profileTasks[x].time = 0;
+        profileTasks[x].longest = 0;
+    }
+    profileIdleReported = idle;
+    profileResetStamp = now;
+}
+
+unsigned char ProfilePending(void) {
+    return profileReportPending;
+}
+
+unsigned char ProfileHostCommand(const unsigned char* payload, unsigned char length) {
+    (void)payload;
+
+    if (length != 0) {
+        return PROFILE_ERROR_FORMAT;
+    }
+#if !PROFILE_ENABLED
+    return PROFILE_ERROR_DISABLED;
+#else
+    profileReportPending = TRUE;
+    return HOST_STATUS_OK;
+#endif
+}
@@ -0,0 +1,97 @@
+/*
+ * File:   profile.h
+ *
+ * CPU load profiler. HighIsr, LowIsr and every scheduler task are timed
+ * off Timer1, the timestamp timer, in timestamp units. Each figure is net
+ * of the interrupts that landed inside it, so HighIsr + LowIsr + tasks +
+ * idle is close to the elapsed time and the rest is scheduler overhead.
+ *
+ * Interrupt latency is read off Timer1 too. TMR1IF is raised as TMR1 rolls
+ * over to zero, so TMR1 at HighIsr entry with TMR1IF set is how long that
+ * flag waited. RC1IF goes through the same vector, the same ISR and the
+ * same di() sections, so that is also its wait to enter HighIsr; the RC1
+ * offset is how far into HighIsr the first RCREG1 read comes. Their sum
+ * bounds RC1IF assertion to service. TMR1IF only comes every 32 ms, so the
+ * worst entry latency needs a run of a few seconds to settle.
+ *
+ * HOST_COMMAND_PROFILE (empty payload) is answered with one
+ * HOST_PACKET_PROFILE covering the time since the previous one, and
+ * starts a new window. Payload, multi-byte fields LE:
+ *
+ *     elapsed             4 bytes, timestamp units in the window
+ *     idle                4 bytes, of those spent in IDLE (scheduler.h)
+ *     HighIsr, LowIsr     2 records of
+ *                             time            4 bytes
+ *                             entries         4 bytes
+ *                             longest         2 bytes, one entry
+ *     entry latency       2 bytes, worst TMR1IF to HighIsr entry
+ *     RC1 offset          2 bytes, worst HighIsr entry to RCREG1 read
+ *     task count          1 byte
+ *     tasks               task count records, in sched table order, of
+ *                             time            4 bytes
+ *                             longest         2 bytes, one run
+ *
+ * The hooks cost time in both ISRs, so they are only compiled in with
+ * PROFILE_ENABLED (app.h, off by default). Building with PROFILE_PIN as
+ * well drives DIG_OUT_14 high while either ISR runs, for a scope, and
+ * leaves two trigger pins.
+ */
+
+#ifndef PROFILE_H
+#define	PROFILE_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#define PROFILE_TASK_MAX            12      // Later tasks run unprofiled
+#define PROFILE_ISR_RECORD_SIZE     10
+#define PROFILE_TASK_RECORD_SIZE    6
+#define PROFILE_HEADER_SIZE         (8 + 2 * PROFILE_ISR_RECORD_SIZE + 5)
+#define PROFILE_PAYLOAD_SIZE(tasks) (PROFILE_HEADER_SIZE + (tasks) * PROFILE_TASK_RECORD_SIZE)
+
+// Host command status codes
+#define PROFILE_ERROR_FORMAT        1       // Payload not empty
+#define PROFILE_ERROR_DISABLED      2       // Built without PROFILE_ENABLED
+
+#define PIN_PROFILE_TRIS            PIN_DIG_OUT_14_TRIS
+#define PIN_PROFILE_LATCH           PIN_DIG_OUT_14_LATCH
+
+void ProfileInitialize(unsigned char taskCount);
+unsigned char ProfilePending(void);
+void ProfileService(void);
+unsigned char ProfileHostCommand(const unsigned char* payload, unsigned char length);
+
+// Hooks, see main.c and scheduler.c
+void ProfileHighEnter(void);
+void ProfileHighExit(void);
+void ProfileLowEnter(void);
+void ProfileLowExit(void);
+void ProfileReceive(void);
+void ProfileTaskBegin(void);
+void ProfileTaskEnd(unsigned char index);
+
+#if PROFILE_ENABLED
+#define PROFILE_HIGH_ENTER()        ProfileHighEnter()
+#define PROFILE_HIGH_EXIT()         ProfileHighExit()
+#define PROFILE_LOW_ENTER()         ProfileLowEnter()
+#define PROFILE_LOW_EXIT()          ProfileLowExit()
+#define PROFILE_RECEIVE()           ProfileReceive()
+#define PROFILE_TASK_BEGIN()        ProfileTaskBegin()
+#define PROFILE_TASK_END(index)     ProfileTaskEnd(index)
+#else
+#define PROFILE_HIGH_ENTER()
+#define PROFILE_HIGH_EXIT()
+#define PROFILE_LOW_ENTER()
+#define PROFILE_LOW_EXIT()
+#define PROFILE_RECEIVE()
+#define PROFILE_TASK_BEGIN()
+#define PROFILE_TASK_END(index)
+#endif
+
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* PROFILE_H */
@@ -0,0 +1,257 @@
+#include <xc.h>
+#include "app.h"
+#include "fifo.h"
+#include "uart.h"
+#include "galaxy.h"
+#include "timestamp.h"
+#include "host.h"
+#include "capture.h"
+#include "poll.h"
+#include "replay.h"
+#include "busconfig.h"
+
+#define REPLAY_MASK                 (REPLAY_BUFFER_SIZE - 1)
+#define REPLAY_RETRY_STAMPS         (20 * TIMESTAMP_TICKS_PER_US)   // DEVICE_TX_FIFO full
+#define REPLAY_CCP_COMPARE          0x0A    // Compare mode, CCP1IF only
+
+static unsigned char replayActive = FALSE;
+static unsigned int replayWords[REPLAY_BUFFER_SIZE];
+static unsigned long replayDelays[REPLAY_BUFFER_SIZE];
+static volatile unsigned char replayRead = 0;   // Advanced by HighIsr
+static unsigned char replayWrite = 0;
+static unsigned char replayCredited = 0;        // replayRead at the last credit
+static unsigned char replaySkipped = 0;         // Fault records not yet credited
+static unsigned long replayLast = 0;            // When the previous word was due
+static unsigned long replayCarry = 0;           // Delta of skipped fault words
+static volatile unsigned char replaySent = FALSE;   // A word has gone out since start
+static unsigned int replayUnderruns = 0;
+static volatile unsigned int replayLate = 0;
+
+void ReplayInitialize(void) {
+    replayActive = FALSE;
+    replayRead = 0;
+    replayWrite = 0;
+    CCPTMRS0bits.C1TSEL = 0;                // Timer1, the timestamp clock
+    CCP1CON = REPLAY_CCP_COMPARE;
+    IPR1bits.CCP1IP = 1;                    // Use high priority ISR
+    PIE1bits.CCP1IE = 0;
+    PIR1bits.CCP1IF = 0;
+}
+
+// Empties the buffer and hands the host a full REPLAY_BUFFER_SIZE credit.
+// The poller shares DEVICE_TX_FIFO, so it is stopped. The driver is held
+// on until ReplayStop, so a word after a gap does not wait out the
+// turnaround.
+void ReplayStart(void) {
+    PIE1bits.CCP1IE = 0;
+    PollStop();
+    replayRead = 0;
+    replayWrite = 0;
+    replayCredited = 0;
+    replaySkipped = 0;
+    replayCarry = 0;
+    replaySent = FALSE;
+    replayUnderruns = 0;
+    replayLate = 0;
+    replayActive = TRUE;
+    UART_StartTransmit(UART1_INDEX);
+}
+
+// Words already in DEVICE_TX_FIFO still go out
+void ReplayStop(void) {
+    PIE1bits.CCP1IE = 0;
+    PIR1bits.CCP1IF = 0;
+    replayActive = FALSE;
+    replayRead = 0;
+    replayWrite = 0;
+}
+
+unsigned char ReplayActive(void) {
+    return replayActive;
+}
+
+// Records sent or skipped since the last credit packet
+unsigned char ReplayPending(void) {
+    return replayActive && (replayRead != replayCredited || replaySkipped != 0);
+}
+
+// CCPR1 matches the low 16 bits of the timestamp. A due stamp already
+// passed, or passed while CCPR1 was being written, raises CCP1IF here.
+static void ReplayArm(unsigned long due) {
+    CCPR1H = (unsigned char)(due >> 8);
+    CCPR1L = (unsigned char)due;
+    if ((long)(TimestampNow() - due) >= 0) {
+        PIR1bits.CCP1IF = 1;
+    }
+    PIE1bits.CCP1IE = 1;
+}
+
+//===============================================================================
+//	Description:	CCP1IF handler. Queues the record that is due and starts
+//					UART1, whose TX1IF is taken next in the same HighIsr pass
+//					and loads TXREG. Each word is due its delta after the
+//					previous one was due, so ISR latency does not stretch the
+//					gaps after it. A word more than REPLAY_LATE_US behind
+//					restarts the schedule from now rather than bunching up
+//					the words behind it. A match up to 32 ms early, from a
+//					delta longer than one Timer1 lap, waits for the next lap.
+//
+//	Params:			NONE
+//
+//	Returns:			NONE
+//===============================================================================
+void ReplayCompareInterrupt(void) {
+    unsigned char slot = replayRead & REPLAY_MASK;
+    unsigned long now;
+    unsigned long due;
+
+    PIR1bits.CCP1IF = 0;
+    now = TimestampNow();
+    due = replayLast + replayDelays[slot];
+    if ((long)(now - due) < 0) {
+        return;
+    }
+    if (IsFifoFull(&buffers[DEVICE_TX_FIFO])) {
+        ReplayArm(now + REPLAY_RETRY_STAMPS);
+        return;
+    }
+    FifoEnqueue(&buffers[DEVICE_TX_FIFO], replayWords[slot]);
+    UART_StartTransmit(UART1_INDEX);
+
+    if (now - due > REPLAY_LATE_STAMPS) {
+        replayLate++;
+        replayLast = now;
+    } else {
+        replayLast = due;
+    }
+    replaySent = TRUE;
+    replayRead++;
+
+    if (replayRead == replayWrite) {
+        PIE1bits.CCP1IE = 0;
+        return;
+    }
+    ReplayArm(replayLast + replayDelays[replayRead & REPLAY_MASK]);
+}
+
+//===============================================================================
+//	Description:	Hands sent and skipped records back to the host, in
+//					batches of REPLAY_CREDIT_BATCH or whenever the buffer
+//					has drained. Call from the main loop.
+//
+//	Params:			NONE
+//
+//	Returns:			NONE
+//===============================================================================
+void ReplayService(void) {
+    unsigned char payload[REPLAY_CREDIT_SIZE];
+    unsigned char interrupts;
+    unsigned char read = replayRead;
+    unsigned char freed = (unsigned char)(read - replayCredited) + replaySkipped;
+    unsigned int late;
+
+    if (!replayActive || freed == 0 || (freed < REPLAY_CREDIT_BATCH && read != replayWrite)) {
+        return;
+    }
+
+    interrupts = INTCONbits.GIEH;
+    INTCONbits.GIEH = 0;
+    late = replayLate;
+    INTCONbits.GIEH = interrupts;
+
+    payload[0] = freed;
+    payload[1] = (unsigned char)replayUnderruns;
+    payload[2] = (unsigned char)(replayUnderruns >> 8);
+    payload[3] = (unsigned char)late;
+    payload[4] = (unsigned char)(late >> 8);
+    if (HostSendPacket(HOST_PACKET_REPLAY_CREDIT, payload, REPLAY_CREDIT_SIZE)) {
+        replayCredited = read;
+        replaySkipped = 0;
+    }
+}
+
+unsigned char ReplayHostStart(const unsigned char* payload, unsigned char length) {
+    (void)payload;
+    (void)length;
+    // ABD is using the baud rate generator as its counter
+    if (BusConfigDetecting()) {
+        return REPLAY_ERROR_STATE;
+    }
+    ReplayStart();
+    return HOST_STATUS_OK;
+}
+
+unsigned char ReplayHostStop(const unsigned char* payload, unsigned char length) {
+    (void)payload;
+    (void)length;
+    ReplayStop();
+    return HOST_STATUS_OK;
+}
+
+//===============================================================================
+//	Description:	HOST_COMMAND_REPLAY_DATA handler. The packet is checked
+//					whole before any record is queued, so a rejected packet
+//					leaves the buffer as it was.
+//
+//	Params:			PAYLOAD			UCHAR*		Capture records
+//					LENGTH			UCHAR		Payload length
+//
+//	Returns:			HOST_STATUS_OK or a REPLAY_ERROR_ code
+//===============================================================================
+unsigned char ReplayHostData(const unsigned char* payload, unsigned char length) {
+    unsigned char interrupts;
+    unsigned char records = 0;
+    unsigned char x = 0;
+
+    if (!replayActive) {
+        return REPLAY_ERROR_STATE;
+    }
+    while (x < length) {
+        if (length - x < 2) {
+            return REPLAY_ERROR_FORMAT;
+        }
+        x += 2 + ((payload[x + 1] >> REPLAY_DELTA_SHIFT) & 0x03);
+        records++;
+    }
+    if (x != length) {
+        return REPLAY_ERROR_FORMAT;
+    }
+    if (records > REPLAY_BUFFER_SIZE - (unsigned char)(replayWrite - replayRead)) {
+        return REPLAY_ERROR_FULL;
+    }
+
+    x = 0;
+    while (x < length) {
+        unsigned int word = payload[x] | ((unsigned int)(payload[x + 1] & 0x0F) << 8);
+        unsigned char deltaBytes = (payload[x + 1] >> REPLAY_DELTA_SHIFT) & 0x03;
+        unsigned long delta = 0;
+
+        x += 2;
+        for (unsigned char k=0; k < deltaBytes; k++) {
+            delta |= (unsigned long)payload[x++] << (8 * k);
+        }
+        if (word & GALAXY_FAULT_MASK) {
+            replayCarry += delta;
+            replaySkipped++;
+            continue;
+        }
+        replayWords[replayWrite & REPLAY_MASK] = word;
+        replayDelays[replayWrite & REPLAY_MASK] = replayCarry + delta;
+        replayCarry = 0;
+        replayWrite++;
+    }
+
+    // HighIsr disarms CCP1 when the buffer runs dry. Time the next word
+    // from now.
+    interrupts = INTCONbits.GIEH;
+    INTCONbits.GIEH = 0;
+    if (!PIE1bits.CCP1IE && replayRead != replayWrite) {
+        if (replaySent) {
+            replayUnderruns++;
+        }
+        replayLast = TimestampNow();
+        ReplayArm(replayLast + replayDelays[replayRead & REPLAY_MASK]);
+    }
+    INTCONbits.GIEH = interrupts;
+    return HOST_STATUS_OK;
+}
@@ -0,0 +1,67 @@
+/*
+ * File:   replay.h
+ *
+ * Replays captured bus traffic onto UART1 with its original timing. The
+ * host streams HOST_COMMAND_REPLAY_DATA packets whose payload is a run of
+ * records, with no header:
+ *
+ *     word low byte
+ *     flags               bits 0-3: word bits 8-11; bits 4-5: delta bytes
+ *     delta               0-3 bytes LE, timestamp units since the previous
+ *                         word went out
+ *
+ * Words with UART fault bits are skipped and their delta carried over to
+ * the next word. The first word after REPLAY_START, or after the buffer
+ * ran dry, is timed from its arrival. CCP1 compares against Timer1 and
+ * sends each word from HighIsr at its due stamp. The RS-485 driver stays
+ * on from REPLAY_START to REPLAY_STOP.
+ *
+ * Flow control is by credit. After REPLAY_START the host may have
+ * REPLAY_BUFFER_SIZE records outstanding, and each HOST_PACKET_REPLAY_CREDIT
+ * hands back more:
+ *
+ *     credits             1 byte, records sent on the bus since the last
+ *                         credit packet
+ *     underruns           2 bytes LE, times the buffer ran dry while
+ *                         words were still arriving
+ *     late                2 bytes LE, words that went out more than
+ *                         REPLAY_LATE_US behind the schedule
+ */
+
+#ifndef REPLAY_H
+#define	REPLAY_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#define REPLAY_BUFFER_SIZE          32      // Records, power of two
+#define REPLAY_RECORD_MAX_SIZE      5
+#define REPLAY_DELTA_SHIFT          4       // Delta byte count in the flags
+#define REPLAY_CREDIT_BATCH         8       // Records freed before a credit goes out
+#define REPLAY_CREDIT_SIZE          5
+#define REPLAY_LATE_US              100
+#define REPLAY_LATE_STAMPS          (REPLAY_LATE_US * TIMESTAMP_TICKS_PER_US)   // Timestamp units
+
+// Host command status codes
+#define REPLAY_ERROR_STATE          1       // Data without REPLAY_START, or start during auto-baud
+#define REPLAY_ERROR_FULL           2       // More records than credit allows
+#define REPLAY_ERROR_FORMAT         3       // Record runs past the payload
+
+void ReplayInitialize(void);
+void ReplayStart(void);
+void ReplayStop(void);
+unsigned char ReplayActive(void);
+unsigned char ReplayPending(void);
+void ReplayCompareInterrupt(void);
+void ReplayService(void);
+unsigned char ReplayHostStart(const unsigned char* payload, unsigned char length);
+unsigned char ReplayHostData(const unsigned char* payload, unsigned char length);
+unsigned char ReplayHostStop(const unsigned char* payload, unsigned char length);
+
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* REPLAY_H */
@@ -0,0 +1,88 @@
+#include <xc.h>
+#include "app.h"
+#include "tick.h"
+#include "timestamp.h"
+#include "scheduler.h"
+#include "profile.h"
+
+static schedTask* schedTasks;
+static unsigned char schedCount = 0;
+static unsigned long schedIdle = 0;             // Timestamp units, free running
+static unsigned long schedIdleReported = 0;
+static unsigned long schedResetStamp = 0;
+
+void SchedInitialize(schedTask* tasks, unsigned char count) {
+    unsigned int now = TickNow();
+
+    schedTasks = tasks;
+    schedCount = count;
+    for (unsigned char x=0; x < count; x++) {
+        tasks[x].lastTick = now;
+    }
+    schedIdle = 0;
+    schedIdleReported = 0;
+    schedResetStamp = TimestampNow();
+}
+
+static unsigned char SchedDue(schedTask* task, unsigned int now) {
+    if (task->ready) {
+        return task->ready();
+    }
+    return (unsigned int)(now - task->lastTick) >= task->periodTicks;
+}
+
+//===============================================================================
+//	Description:	One main loop pass. Runs every task that is due, then
+//					idles until the next interrupt if none is due any more.
+//
+//	Params:			NONE
+//
+//	Returns:			NONE
+//===============================================================================
+void SchedService(void) {
+    unsigned int now = TickNow();
+    unsigned char x;
+
+    for (x=0; x < schedCount; x++) {
+        schedTask* task = &schedTasks[x];
+        if (SchedDue(task, now)) {
+            // A late pass runs a periodic task once, not once per missed tick
+            task->lastTick = now;
+            PROFILE_TASK_BEGIN();
+            task->run();
+            PROFILE_TASK_END(x);
+        }
+    }
+
+    // A masked interrupt still wakes the core, it is taken after ei()
+    di();
+    now = TickNow();
+    for (x=0; x < schedCount; x++) {
+        if (SchedDue(&schedTasks[x], now)) {
+            break;
+        }
+    }
+    if (x == schedCount) {
+        unsigned long start = TimestampNow();
+        OSCCONbits.IDLEN = 1;
+        SLEEP();
+        NOP();
+        schedIdle += TimestampNow() - start;
+    }
+    ei();
+}
+
+void SchedLoadSnapshot(unsigned long* elapsed, unsigned long* idle, unsigned char reset) {
+    unsigned long now = TimestampNow();
+
+    *elapsed = now - schedResetStamp;
+    *idle = schedIdle - schedIdleReported;
+    if (reset) {
+        schedResetStamp = now;
+        schedIdleReported = schedIdle;
+    }
+}
+
+unsigned long SchedIdleTime(void) {
+    return schedIdle;
+}
@@ -0,0 +1,43 @@
+/*
+ * File:   scheduler.h
+ *
+ * Cooperative scheduler for the main loop. Periodic tasks run once every
+ * periodTicks system ticks; event tasks run on each pass where their ready
+ * check is TRUE. Tasks run in table order.
+ *
+ * When nothing is ready the core goes to IDLE mode with interrupts masked,
+ * so a word arriving between the checks and SLEEP still wakes it. IDLE
+ * keeps the peripheral clocks, and the UARTs and timers run on; full SLEEP
+ * would stop the baud rate generators. The ISRs run after the wake, then
+ * the next pass. Time spent idle is counted for the stats dump.
+ */
+
+#ifndef SCHEDULER_H
+#define	SCHEDULER_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    void (*run)(void);
+    unsigned char (*ready)(void);           // Event task, NULL for periodic
+    unsigned int periodTicks;               // Periodic task
+    unsigned int lastTick;
+} schedTask;
+
+void SchedInitialize(schedTask* tasks, unsigned char count);
+void SchedService(void);
+
+// Timestamp units since the last reset, and how many of them were idle
+void SchedLoadSnapshot(unsigned long* elapsed, unsigned long* idle, unsigned char reset);
+
+// Free running idle total, for readers that keep their own window
+unsigned long SchedIdleTime(void);
+
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* SCHEDULER_H */
@@ -0,0 +1,388 @@
+/*
+ * File:   galaxybench.c
+ *
+ * Times the per-word firmware paths on the host, as a regression check of
+ * the C code between changes.
+ *
+ *   galaxybench [-b baseline] [-w baseline] [-r percent] [file]
+ *
+ * The word stream is synthetic poll traffic or a word file (stimulus.h).
+ * A pass runs a case over the whole stream in batches of BENCH_BATCH
+ * words. Each of BENCH_SAMPLES samples times one pass of every case, its
+ * overhead and the reference kernel, after BENCH_WARMUP_SAMPLES untimed.
+ * The host clock wanders by a third on a shared machine, in spells that
+ * can outlast one case, so the samples sweep all the cases together and
+ * the fastest pass of each is kept.
+ *
+ * Each case is reported in host ns and in steps of the reference kernel,
+ * which follows a chain through a 256 byte table so each step waits on
+ * the last. Steps cancel most of the host's clock speed, so they are what
+ * the baseline holds. Neither is a PIC18 cycle count: the host does 16
+ * and 32 bit arithmetic in one instruction and has no banking, so a
+ * change that only hurts XC8 output passes here. Count PIC cycles with
+ * the MPLAB simulator stopwatch.
+ *
+ * GetChar9 goes through the sim.c register accessors, so its host time
+ * includes model overhead that plain SFR access on the PIC does not have.
+ *
+ * Before timing, crc_update is checked against a bitwise CRC-16/MODBUS
+ * for every CRC value and byte, and a mismatch fails the run.
+ *
+ * With -b the run fails if any case takes more than -r percent (default
+ * BENCH_TOLERANCE_PERCENT) more steps than the baseline.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <xc.h>
+#include "app.h"
+#include "fifo.h"
+#include "uart.h"
+#include "galaxy.h"
+#include "stats.h"
+#include "sim.h"
+#include "stimulus.h"
+
+#define BENCH_WORDS                 8192    // Stream length, repeated from the source
+#define BENCH_BATCH                 64      // Fits a FIFO
+#define BENCH_SAMPLES               2000
+#define BENCH_WARMUP_SAMPLES        10
+#define BENCH_REFERENCE_STEPS       (1UL << 16)
+#define BENCH_TOLERANCE_PERCENT     25
+#define BENCH_WARMUP_NS             200e6
+
+#ifdef GALAXY_CRC_NIBBLE_TABLE
+#define BENCH_CRC_TABLE             "nibble"
+#define BENCH_CRC_TABLE_BYTES       32
+#else
+#define BENCH_CRC_TABLE             "split"
+#define BENCH_CRC_TABLE_BYTES       512
+#endif
+
+// Word storage in one buffer16 on the PIC, the indexes and counters
+// are the same in both layouts
+#ifdef FIFO_PACKED_STORAGE
+#define BENCH_FIFO_LAYOUT           "packed"
+#define BENCH_FIFO_STORAGE_BYTES    (FIFO_SIZE + FIFO_SIZE / 2)
+#else
+#define BENCH_FIFO_LAYOUT           "unpacked"
+#define BENCH_FIFO_STORAGE_BYTES    (FIFO_SIZE * 2)
+#endif
+
+typedef struct {
+    const char* name;
+    void (*run)(const unsigned int* words, unsigned int count);
+    void (*overhead)(const unsigned int* words, unsigned int count);
+    double ns;                              // Per word
+    double steps;                           // Per word, in reference steps
+} benchCase;
+
+static unsigned int words[BENCH_WORDS];
+static unsigned int benchSink;
+static buffer16 benchFifo;
+static galaxyDecoder benchDecoder;
+static volatile unsigned char referenceTable[256];
+
+static double Now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void FillFifo(const unsigned int* w, unsigned int count) {
+    benchFifo.read = benchFifo.write;
+    for (unsigned int i=0; i < count; i++) {
+        FifoEnqueue(&benchFifo, w[i]);
+    }
+}
+
+static void RunFifoDequeue(const unsigned int* w, unsigned int count) {
+    FillFifo(w, count);
+    for (unsigned int i=0; i < count; i++) {
+        benchSink += FifoDequeue(&benchFifo);
+    }
+}
+
+static void InjectWords(const unsigned int* w, unsigned int count) {
+    for (unsigned int i=0; i < count; i++) {
+        SimRxInject(UART1_INDEX, w[i]);
+        SimRcsta(UART1_INDEX)->CREN = 1;
+        SimUartRead(UART1_INDEX);
+    }
+}
+
+static void RunGetChar9(const unsigned int* w, unsigned int count) {
+    for (unsigned int i=0; i < count; i++) {
+        SimRxInject(UART1_INDEX, w[i]);
+        benchSink += GetChar9(UART1_INDEX);
+    }
+}
+
+static void RunComputeCrc(const unsigned int* w, unsigned int count) {
+    benchSink += compute_crc((unsigned int*)w, count);
+}
+
+static void RunGalaxyDecode(const unsigned int* w, unsigned int count) {
+    for (unsigned int i=0; i < count; i++) {
+        GalaxyDecode(&benchDecoder, w[i], i);
+        if (GalaxyFramePeek(&benchDecoder)) {
+            GalaxyFrameRelease(&benchDecoder);
+        }
+    }
+}
+
+static void RunDigitalBreakout(const unsigned int* w, unsigned int count) {
+    for (unsigned int i=0; i < count; i++) {
+        DigitalBreakout(w[i]);
+    }
+}
+
+// Address words stand in for a completed frame, so both switch arms run
+static void RunStatsWord(const unsigned int* w, unsigned int count) {
+    for (unsigned int i=0; i < count; i++) {
+        StatsWord(w[i], (w[i] & GALAXY_ADDRESS_FLAG) ? GALAXY_DECODE_FRAME : GALAXY_DECODE_NONE);
+    }
+}
+
+static void RunNibbleToAscii(const unsigned int* w, unsigned int count) {
+    for (unsigned int i=0; i < count; i++) {
+        benchSink += NibbleToAscii((unsigned char)w[i]);
+    }
+}
+
+static void RunNothing(const unsigned int* w, unsigned int count) {
+    (void)w;
+    (void)count;
+}
+
+static benchCase cases[] = {
+    { "FifoEnqueue",        FillFifo,           NULL },
+    { "FifoDequeue",        RunFifoDequeue,     FillFifo },
+    { "GetChar9",           RunGetChar9,        InjectWords },
+    { "compute_crc",        RunComputeCrc,      NULL },
+    { "GalaxyDecode",       RunGalaxyDecode,    NULL },
+    { "DigitalBreakout",    RunDigitalBreakout, NULL },
+    { "StatsWord",          RunStatsWord,       NULL },
+    { "NibbleToAscii",      RunNibbleToAscii,   NULL },
+};
+#define BENCH_CASE_COUNT    (sizeof(cases) / sizeof(cases[0]))
+
+// One pass over the stream, in ns
+static double TimePass(void (*run)(const unsigned int*, unsigned int)) {
+    double start = Now();
+
+    for (unsigned int i=0; i < BENCH_WORDS; i += BENCH_BATCH) {
+        run(&words[i], BENCH_BATCH);
+    }
+    return Now() - start;
+}
+
+// CRC-16/MODBUS one bit at a time, the reference for crc_update
+static unsigned short CrcBitwise(unsigned short crc, unsigned char data) {
+    crc ^= data;
+    for (unsigned char bit=0; bit < 8; bit++) {
+        crc = (crc & 0x0001) ? (crc >> 1) ^ 0xA001 : crc >> 1;
+    }
+    return crc;
+}
+
+// Every CRC value against every byte, FALSE on the first mismatch
+static unsigned char CheckCrc(void) {
+    for (unsigned long crc=0; crc <= 0xFFFF; crc++) {
+        for (unsigned int data=0; data <= 0xFF; data++) {
+            unsigned short expected = CrcBitwise((unsigned short)crc, (unsigned char)data);
+            unsigned short actual = crc_update((unsigned short)crc, (unsigned char)data);
+
+            if (actual != expected) {
+                printf("crc_update(0x%04lX, 0x%02X) = 0x%04X, bitwise 0x%04X\n", crc, data, actual, expected);
+                return FALSE;
+            }
+        }
+    }
+    return TRUE;
+}
+
+// Lets the host clock ramp up before anything is timed
+static void Warmup(void) {
+    for (unsigned int i=0; i < 256; i++) {
+        referenceTable[i] = (unsigned char)(i * 37 + 1);    // One cycle through all 256
+    }
+    for (double start = Now(); Now() - start < BENCH_WARMUP_NS; ) {
+        benchSink += referenceTable[benchSink & 0xFF];
+    }
+}
+
+// One pass of the reference kernel, in ns
+static double TimeReference(void) {
+    unsigned char x = 0;
+    double start = Now();
+    double ns;
+
+    for (unsigned long i=0; i < BENCH_REFERENCE_STEPS; i++) {
+        x = referenceTable[x];
+    }
+    ns = Now() - start;
+    benchSink += x;
+    return ns;
+}
+
+//===============================================================================
+//	Description:	Times every case and the reference kernel. Each sample
+//					runs all of them once, so a slow spell on the host lands
+//					on every case alike, and the fastest pass of each is
+//					kept: noise only ever adds time.
+//
+//	Params:			NONE
+//
+//	Returns:			Host ns per reference step
+//===============================================================================
+static double RunCases(void) {
+    static double run[BENCH_CASE_COUNT];
+    static double overhead[BENCH_CASE_COUNT];
+    double reference = 0;
+    double step;
+
+    for (unsigned int n=0; n < BENCH_WARMUP_SAMPLES + BENCH_SAMPLES; n++) {
+        unsigned char first = (n == BENCH_WARMUP_SAMPLES);
+        unsigned char timed = (n >= BENCH_WARMUP_SAMPLES);
+        double t = TimeReference();
+
+        if (timed && (first || t < reference)) {
+            reference = t;
+        }
+        for (unsigned int c=0; c < BENCH_CASE_COUNT; c++) {
+            double r = TimePass(cases[c].run);
+            double o = TimePass(cases[c].overhead ? cases[c].overhead : RunNothing);
+
+            if (timed && (first || r < run[c])) {
+                run[c] = r;
+            }
+            if (timed && (first || o < overhead[c])) {
+                overhead[c] = o;
+            }
+        }
+    }
+    step = reference / BENCH_REFERENCE_STEPS;
+    for (unsigned int c=0; c < BENCH_CASE_COUNT; c++) {
+        double perWord = (run[c] - overhead[c]) / BENCH_WORDS;
+
+        cases[c].ns = perWord > 0 ? perWord : 0;
+        cases[c].steps = cases[c].ns / step;
+    }
+    return step;
+}
+
+static int ReadBaseline(const char* path, double tolerance) {
+    FILE* f = fopen(path, "r");
+    char line[128];
+    char name[64];
+    double steps;
+    int regressions = 0;
+
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    while (fgets(line, sizeof(line), f)) {
+        if (line[0] == '#' || sscanf(line, "%63s %lf", name, &steps) != 2) {
+            continue;
+        }
+        for (unsigned int c=0; c < BENCH_CASE_COUNT; c++) {
+            if (strcmp(cases[c].name, name) == 0 && cases[c].steps > steps * (1 + tolerance / 100)) {
+                printf("REGRESSION %-16s %.2f steps, baseline %.2f\n", name, cases[c].steps, steps);
+                regressions++;
+            }
+        }
+    }
+    fclose(f);
+    return regressions;
+}
+
+static int WriteBaseline(const char* path) {
+    FILE* f = fopen(path, "w");
+
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    fprintf(f, "# galaxybench baseline, host time per word in reference steps\n");
+    for (unsigned int c=0; c < BENCH_CASE_COUNT; c++) {
+        fprintf(f, "%-16s %.2f\n", cases[c].name, cases[c].steps);
+    }
+    fclose(f);
+    return 0;
+}
+
+static void Usage(void) {
+    fprintf(stderr, "usage: galaxybench [-b baseline] [-w baseline] [-r percent] [file]\n");
+    exit(2);
+}
+
+int main(int argc, char** argv) {
+    stimulus source;
+    double step;
+    double tolerance = BENCH_TOLERANCE_PERCENT;
+    const char* baseline = NULL;
+    const char* output = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "b:w:r:")) != -1) {
+        switch (opt) {
+            case 'b': baseline = optarg; break;
+            case 'w': output = optarg; break;
+            case 'r': tolerance = atof(optarg); break;
+            default: Usage();
+        }
+    }
+    if (optind < argc) {
+        if (StimulusLoad(&source, argv[optind]) != 0) {
+            return 2;
+        }
+    } else {
+        StimulusPollTraffic(&source, 0);
+    }
+    for (unsigned int i=0; i < BENCH_WORDS; i++) {
+        words[i] = source.words[i % source.count].word;
+    }
+    StimulusFree(&source);
+
+    SimReset();
+    UART_Initialize(UART1_INDEX, UART_BAUD_CODE_19200, UART_9BIT_MODE, UART_INTERRUPTS_DISABLED);
+    FifoInitialize(&benchFifo);
+    GalaxyDecoderInitialize(&benchDecoder);
+
+    if (!CheckCrc()) {
+        return 1;
+    }
+    Warmup();
+    step = RunCases();
+    printf("%u words%s, %.3f host ns per reference step\n", BENCH_WORDS,
+           optind < argc ? "" : ", synthetic poll traffic", step);
+    printf("FIFO storage %s, %u bytes per FIFO, %u for all %u\n", BENCH_FIFO_LAYOUT,
+           BENCH_FIFO_STORAGE_BYTES, BENCH_FIFO_STORAGE_BYTES * FIFO_COUNT, FIFO_COUNT);
+    printf("CRC table %s, %u bytes, checked bitwise, compute_crc is per byte\n",
+           BENCH_CRC_TABLE, BENCH_CRC_TABLE_BYTES);
+    printf("Host timings only, not PIC18 cycles\n\n");
+    printf("%-16s %9s %9s\n", "", "ns/word", "steps");
+    for (unsigned int c=0; c < BENCH_CASE_COUNT; c++) {
+        printf("%-16s %9.2f %9.2f\n", cases[c].name, cases[c].ns, cases[c].steps);
+    }
+
+    if (output && WriteBaseline(output) != 0) {
+        return 2;
+    }
+    if (baseline) {
+        int regressions = ReadBaseline(baseline, tolerance);
+        if (regressions < 0) {
+            return 2;
+        }
+        if (regressions) {
+            return 1;
+        }
+        printf("\nwithin %.0f%% of %s\n", tolerance, baseline);
+    }
+    return 0;
+}
@@ -0,0 +1,995 @@
+/*
+ * File:   galaxysim.c
+ *
+ * Runs the firmware on the host against the sim.c peripheral model. Bus
+ * traffic is fed into UART1 and the capture stream coming out of UART2 is
+ * decoded and checked word for word against what was sent.
+ *
+ *   galaxysim [-t seconds] [-b baud] [-g gap_us] [-l loop_us] [-i isr_us]
+ *             [-T pin=word[/mask],...] [-F [h]address,...[/command,...]]
+ *             [-s ticks] [-r] [-o capture] [-B baud] [-a] [-X] [-p] [-v] [file]
+ *
+ * Without a file the bus carries POLL_SLOT frames for every slot, each
+ * followed by a short response. A word file (see stimulus.h) is replayed
+ * until the run time is up.
+ *
+ * -T loads a trigger pattern over the host link before traffic starts, for
+ * example -T 13=1ff,06,50/xx to fire DIG_OUT_13 on POLL_SLOT for any slot.
+ * "xx" is a wildcard and /mask limits the bits compared. Up to
+ * TRIGGER_MAX_PATTERNS - 1 patterns can be added to the default one.
+ *
+ * -F sets the address and command filter, hex lists with an empty list
+ * accepting everything and a leading h for ADDEN hardware address detect.
+ * -F 10 keeps only slot 0 responses, -F /50 only POLL_SLOT frames. The
+ * capture stream is then checked against the same filter applied here.
+ *
+ * -s asks for a stats dump every so many ticks and prints the last one.
+ *
+ * -r streams the traffic to the replay engine over the host link instead,
+ * under its credit flow control. The firmware transmits it on UART1, the
+ * line echo brings it back into the capture stream, and the gaps on the
+ * wire are compared with the ones asked for.
+ *
+ * -o writes every byte the firmware sends on UART2 to a file, the same
+ * log the analyzer in ../analyzer reads.
+ *
+ * -B switches the firmware to another bus rate over the host link, so
+ * -b 57600 -B 57600 runs clean where -b 57600 alone gives framing errors.
+ * -a has the firmware detect the rate instead. Traffic sent before it
+ * reports a lock, and until the line has been quiet for AUTOBAUD_SETTLE_US
+ * after, is not checked.
+ *
+ * -X opens the bridge and streams the traffic through it instead, as a PC
+ * bus master would, under its credit flow control. The line echo brings
+ * every word back through the bridge, where it is checked like a capture
+ * record. The forwarding delay is from the last host byte of a word, or
+ * the previous stop bit if later, to its start bit on UART1. It does not
+ * mix with -r, -a or -F.
+ *
+ * -p asks for a profile report halfway through the drain time, so it does
+ * not crowd out the last capture packets, and prints it. Code
+ * runs in zero simulated time, so only the latency figures mean much here;
+ * they are shown next to the longest RC1IF wait in the UART model. Not
+ * with -X. Needs a build with the profiler in, for example
+ * make clean all DEFINES=-DPROFILE_ENABLED=TRUE.
+ *
+ * Exit status is 0 when every word sent made it into the capture stream.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <xc.h>
+#include "app.h"
+#include "fifo.h"
+#include "uart.h"
+#include "galaxy.h"
+#include "host.h"
+#include "capture.h"
+#include "timestamp.h"
+#include "trigger.h"
+#include "filter.h"
+#include "stats.h"
+#include "replay.h"
+#include "tick.h"
+#include "busconfig.h"
+#include "bridge.h"
+#include "profile.h"
+#include "sim.h"
+#include "stimulus.h"
+
+#define LOOKAHEAD_US        10000           // How far ahead of simNow the line is filled
+#define DRAIN_US            100000          // Run time after the last word for capture to flush
+#define AUTOBAUD_SETTLE_US  30000           // Quiet line after a lock, longer than a capture flush
+
+static stimulus traffic;
+static size_t trafficNext;
+static size_t trafficSent;
+static unsigned long frameGapUs = 1000;
+
+static unsigned short* sent;
+static size_t sentCount;
+static size_t sentCapacity;
+
+static struct {
+    unsigned char packet[3 + 255 + 2];
+    unsigned int length;
+    unsigned char haveSequence;
+    unsigned char sequence;
+    unsigned long bytes;
+    unsigned long packets;
+    unsigned long records;
+    unsigned long sequenceGaps;
+    unsigned long crcErrors;
+    unsigned long syncErrors;
+    unsigned long mismatches;
+    unsigned long acks;
+    unsigned long nacks;
+} capture;
+
+static unsigned long hostCommands;
+
+// Host side of a replay
+static struct {
+    unsigned char enabled;
+    unsigned int credit;
+    double scheduleUs;                      // Wire time of the words queued so far
+    unsigned long underruns;
+    unsigned long late;
+    unsigned long credited;
+    unsigned long long* due;                // Stop bit time asked for, per word, in clocks
+    size_t dueCount;
+    size_t dueCapacity;
+    size_t transmitted;
+    simTime firstStop;
+    double errorSum;
+    double errorMax;
+} replay;
+
+// Last complete stats dump
+static struct {
+    unsigned long dumps;
+    unsigned char counters[STATS_PAYLOAD_SIZE];
+    unsigned char last[STATS_PAYLOAD_SIZE];
+    unsigned int addresses[256];
+    unsigned int lastAddresses[256];
+} statsDump;
+
+// Host side of a bus rate change
+static struct {
+    unsigned char detecting;                // Words sent now are not checked
+    simTime resume;                         // Checked traffic starts here, 0 until locked
+    unsigned long reports;
+    unsigned char report[BUS_CONFIG_REPORT_SIZE];
+    size_t trainingWords;
+    unsigned long discarded;                // Records captured while detecting
+} bus;
+
+// Host side of a bridge session
+static struct {
+    unsigned char enabled;
+    unsigned char open;                     // Acknowledged, UART2 carries the byte stream
+    unsigned char exitSent;
+    unsigned char closed;                   // Device sent BRIDGE_CODE_EXIT
+    unsigned int credit;
+    unsigned long credited;
+    unsigned char escape[BRIDGE_WORD_MAX_SIZE];
+    unsigned char escapeLength;
+    unsigned long faults;
+    simTime* arrived;                       // Last host byte of each word, stop bit time
+    size_t arrivedCount;
+    size_t arrivedCapacity;
+    size_t transmitted;
+    simTime wordClocks;                     // One UART1 word at the firmware's rate
+    simTime lastStop;
+    double delaySum;
+    double delayMax;
+} bridge;
+
+// Last profile report
+static struct {
+    unsigned char enabled;
+    unsigned char requested;
+    unsigned long reports;
+    unsigned char report[PROFILE_PAYLOAD_SIZE(PROFILE_TASK_MAX)];
+} profile;
+
+static const unsigned long busRates[UART_BAUD_CODE_COUNT] = {
+    UART_BAUD_4800, UART_BAUD_9600, UART_BAUD_19200,
+    UART_BAUD_38400, UART_BAUD_57600, UART_BAUD_115200,
+    UART_BAUD_460800,
+};
+
+static unsigned char triggerCount = 1;      // Pattern 0 is the firmware default
+
+// Reference copy of the firmware filter, applied to the words sent
+static struct {
+    unsigned char enabled;
+    unsigned char addresses[256];
+    unsigned char commands[256];
+    unsigned char anyAddress;
+    unsigned char anyCommand;
+    unsigned int frame[GALAXY_MAX_FRAME_WORDS + 1];
+    unsigned int count;
+} reference = { 0, { 0 }, { 0 }, 1, 1 };
+
+static int verbose;
+static FILE* hostLog;
+
+static void Expect(unsigned int word) {
+    if (sentCount == sentCapacity) {
+        sentCapacity = sentCapacity ? sentCapacity * 2 : 4096;
+        sent = realloc(sent, sentCapacity * sizeof(*sent));
+    }
+    sent[sentCount++] = word;
+}
+
+// A frame passes when its address and, once it has one, its command word
+// are accepted. Frames kept whole, so decide at the next address word.
+static void ReferenceFrameEnd(void) {
+    unsigned int* frame = reference.frame;
+    unsigned int count = reference.count;
+
+    reference.count = 0;
+    if (count == 0 || !(frame[0] & GALAXY_ADDRESS_FLAG)) {
+        return;
+    }
+    if (!reference.anyAddress && !reference.addresses[frame[0] & 0xFF]) {
+        return;
+    }
+    if (!reference.anyCommand &&
+            (count <= FILTER_COMMAND_INDEX || !reference.commands[frame[FILTER_COMMAND_INDEX] & 0xFF])) {
+        return;
+    }
+    for (unsigned int i=0; i < count; i++) {
+        Expect(frame[i]);
+    }
+}
+
+static void ReferenceWord(unsigned int word) {
+    if (!reference.enabled) {
+        Expect(word);
+        return;
+    }
+    if (word & GALAXY_ADDRESS_FLAG) {
+        ReferenceFrameEnd();
+    }
+    if (reference.count <= GALAXY_MAX_FRAME_WORDS) {
+        reference.frame[reference.count++] = word;
+    }
+}
+
+static void SendNextWord(void) {
+    const stimulusWord* w = &traffic.words[trafficNext];
+
+    SimLineSend(UART1_INDEX, w->word, (simTime)w->gapUs * SIM_CLOCKS_PER_US);
+    if (bus.detecting) {
+        bus.trainingWords++;
+    } else {
+        ReferenceWord(w->word);
+    }
+    trafficSent++;
+    trafficNext = (trafficNext + 1) % traffic.count;
+}
+
+static void CaptureRecord(unsigned int word, unsigned long long stamp) {
+    if (bus.detecting) {
+        bus.discarded++;
+        return;
+    }
+    if (verbose) {
+        printf("%14.1f us  %03X%s%s%s\n", stamp / (double)TIMESTAMP_TICKS_PER_US, word & 0x1FF,
+               (word & UART_FAULT_FRAMING_ERROR) ? " FERR" : "",
+               (word & UART_FAULT_OVERRUN_ERROR) ? " OERR" : "",
+               (word & UART_FAULT_NO_DATA_AVAILABLE) ? " NODATA" : "");
+    }
+    // After a lost packet the two streams no longer line up
+    if (capture.sequenceGaps == 0 &&
+            (capture.records >= sentCount || sent[capture.records] != (word & 0x1FF))) {
+        capture.mismatches++;
+    }
+    capture.records++;
+}
+
+static void CapturePacket(const unsigned char* packet, unsigned int length) {
+    const unsigned char* payload = packet + 3;
+    unsigned char payloadLength = packet[2];
+    unsigned short crc = GALAXY_CRC_INITIAL;
+    unsigned long long stamp;
+    unsigned int i;
+
+    for (i=1; i < 3 + payloadLength; i++) {
+        crc = crc_update(crc, packet[i]);
+    }
+    if (packet[length - 2] != (crc >> 8) || packet[length - 1] != (crc & 0xFF)) {
+        capture.crcErrors++;
+        return;
+    }
+    capture.packets++;
+    if (packet[1] == HOST_PACKET_ACK && payloadLength == 2) {
+        capture.acks++;
+        if (payload[1] != HOST_STATUS_OK) {
+            fprintf(stderr, "command %02X failed with status %u\n", payload[0], payload[1]);
+            capture.nacks++;
+        } else if (payload[0] == HOST_COMMAND_BRIDGE) {
+            bridge.open = 1;
+            bridge.credit = BRIDGE_CREDIT_INITIAL;
+        }
+        return;
+    }
+    if (packet[1] == HOST_PACKET_REPLAY_CREDIT && payloadLength == REPLAY_CREDIT_SIZE) {
+        replay.credit += payload[0];
+        replay.credited += payload[0];
+        replay.underruns = payload[1] | (payload[2] << 8);
+        replay.late = payload[3] | (payload[4] << 8);
+        return;
+    }
+    if (packet[1] == HOST_PACKET_BUS_CONFIG && payloadLength == BUS_CONFIG_REPORT_SIZE) {
+        memcpy(bus.report, payload, BUS_CONFIG_REPORT_SIZE);
+        bus.reports++;
+        if (bus.detecting && payload[2] != BUS_STATE_DETECTING && !bus.resume) {
+            bus.resume = (SimLineIdleAt(UART1_INDEX) > simNow ? SimLineIdleAt(UART1_INDEX) : simNow) +
+                         (simTime)AUTOBAUD_SETTLE_US * SIM_CLOCKS_PER_US;
+        }
+        return;
+    }
+    if (packet[1] == HOST_PACKET_PROFILE && payloadLength >= PROFILE_HEADER_SIZE &&
+            payload[PROFILE_HEADER_SIZE - 1] <= PROFILE_TASK_MAX &&
+            payloadLength == PROFILE_PAYLOAD_SIZE(payload[PROFILE_HEADER_SIZE - 1])) {
+        memcpy(profile.report, payload, payloadLength);
+        profile.reports++;
+        return;
+    }
+    if (packet[1] == HOST_PACKET_STATS && payloadLength == STATS_PAYLOAD_SIZE) {
+        memcpy(statsDump.counters, payload, STATS_PAYLOAD_SIZE);
+        memset(statsDump.addresses, 0, sizeof(statsDump.addresses));
+        return;
+    }
+    if (packet[1] == HOST_PACKET_STATS_ADDRESSES && payloadLength >= 1) {
+        for (i=1; i + STATS_ADDRESS_RECORD_SIZE <= payloadLength; i += STATS_ADDRESS_RECORD_SIZE) {
+            statsDump.addresses[payload[i]] = payload[i+1];
+        }
+        if (payload[0] & STATS_ADDRESSES_LAST) {
+            memcpy(statsDump.last, statsDump.counters, STATS_PAYLOAD_SIZE);
+            memcpy(statsDump.lastAddresses, statsDump.addresses, sizeof(statsDump.addresses));
+            statsDump.dumps++;
+        }
+        return;
+    }
+    if (packet[1] != HOST_PACKET_CAPTURE || payloadLength < CAPTURE_HEADER_SIZE) {
+        return;
+    }
+
+    if (capture.haveSequence) {
+        capture.sequenceGaps += (unsigned char)(payload[0] - capture.sequence - 1);
+    }
+    capture.haveSequence = 1;
+    capture.sequence = payload[0];
+
+    stamp = payload[1] | ((unsigned long)payload[2] << 8) | ((unsigned long)payload[3] << 16) | ((unsigned long)payload[4] << 24);
+    i = CAPTURE_HEADER_SIZE;
+    while (i + CAPTURE_RECORD_MIN_SIZE <= payloadLength) {
+        unsigned int word = payload[i] | ((payload[i+1] & CAPTURE_CONTROL_BIT8) ? GALAXY_ADDRESS_FLAG : 0);
+        unsigned long delta = payload[i+1] & CAPTURE_ESCAPE;
+
+        i += 2;
+        if (delta == CAPTURE_ESCAPE && i < payloadLength) {
+            unsigned char deltaBytes = (payload[i] >> CAPTURE_DELTA_SHIFT) & 0x03;
+
+            word = (word & 0xFF) | ((payload[i++] & 0x0F) << 8);
+            delta = 0;
+            for (unsigned char k=0; k < deltaBytes && i < payloadLength; k++) {
+                delta |= (unsigned long)payload[i++] << (8 * k);
+            }
+        }
+        stamp += (unsigned long long)delta << CAPTURE_DELTA_UNIT_SHIFT;
+        CaptureRecord(word, stamp);
+    }
+}
+
+static void BridgeSend(unsigned char byte) {
+    SimLineSend(HOST_UART_INDEX, byte, 0);
+}
+
+// Escapes as many words as credit allows onto UART2
+static void BridgeFeed(void) {
+    while (bridge.credit != 0 && SimLineSpace(HOST_UART_INDEX) >= BRIDGE_WORD_MAX_SIZE &&
+            SimLineIdleAt(HOST_UART_INDEX) < simNow + (simTime)LOOKAHEAD_US * SIM_CLOCKS_PER_US) {
+        unsigned int word = traffic.words[trafficNext].word & 0x1FF;
+        unsigned char low = (unsigned char)word;
+
+        if (word & GALAXY_ADDRESS_FLAG) {
+            BridgeSend(BRIDGE_ESCAPE);
+            BridgeSend(BRIDGE_CODE_ADDRESS);
+        } else if (low == BRIDGE_ESCAPE) {
+            BridgeSend(BRIDGE_ESCAPE);
+            low = BRIDGE_CODE_ESCAPE;
+        }
+        BridgeSend(low);
+
+        if (bridge.arrivedCount == bridge.arrivedCapacity) {
+            bridge.arrivedCapacity = bridge.arrivedCapacity ? bridge.arrivedCapacity * 2 : 4096;
+            bridge.arrived = realloc(bridge.arrived, bridge.arrivedCapacity * sizeof(*bridge.arrived));
+        }
+        bridge.arrived[bridge.arrivedCount++] = SimLineIdleAt(HOST_UART_INDEX);
+
+        ReferenceWord(word);
+        trafficSent++;
+        trafficNext = (trafficNext + 1) % traffic.count;
+        bridge.credit--;
+    }
+}
+
+// Unescapes the device side of the bridge
+static void BridgeReceive(unsigned char byte, simTime when) {
+    unsigned long long stamp = when / (SIM_CLOCKS_PER_US / TIMESTAMP_TICKS_PER_US);
+    unsigned char needed;
+
+    if (bridge.escapeLength == 0) {
+        if (byte == BRIDGE_ESCAPE) {
+            bridge.escape[bridge.escapeLength++] = byte;
+        } else {
+            CaptureRecord(byte, stamp);
+        }
+        return;
+    }
+    bridge.escape[bridge.escapeLength++] = byte;
+    switch (bridge.escape[1]) {
+        case BRIDGE_CODE_ADDRESS: needed = 3; break;
+        case BRIDGE_CODE_CREDIT: needed = 3; break;
+        case BRIDGE_CODE_FAULT: needed = 4; break;
+        default: needed = 2; break;
+    }
+    if (bridge.escapeLength < needed) {
+        return;
+    }
+    bridge.escapeLength = 0;
+    switch (bridge.escape[1]) {
+        case BRIDGE_CODE_ADDRESS:
+            CaptureRecord(GALAXY_ADDRESS_FLAG | bridge.escape[2], stamp);
+            break;
+        case BRIDGE_CODE_ESCAPE:
+            CaptureRecord(BRIDGE_ESCAPE, stamp);
+            break;
+        case BRIDGE_CODE_FAULT:
+            bridge.faults++;
+            CaptureRecord(((unsigned int)bridge.escape[2] << 8) | bridge.escape[3], stamp);
+            break;
+        case BRIDGE_CODE_CREDIT:
+            bridge.credit += bridge.escape[2];
+            bridge.credited += bridge.escape[2];
+            break;
+        case BRIDGE_CODE_EXIT:
+            bridge.open = 0;
+            bridge.closed = 1;
+            break;
+        default:
+            capture.syncErrors++;
+            break;
+    }
+}
+
+static void BridgeTransmitted(simTime when) {
+    simTime start = when - bridge.wordClocks;
+    simTime ready;
+    double delay;
+
+    if (bridge.transmitted >= bridge.arrivedCount) {
+        return;
+    }
+    ready = bridge.arrived[bridge.transmitted];
+    if (bridge.transmitted && bridge.lastStop > ready) {
+        ready = bridge.lastStop;
+    }
+    delay = ((double)start - (double)ready) / SIM_CLOCKS_PER_US;
+    bridge.delaySum += delay;
+    if (delay > bridge.delayMax) {
+        bridge.delayMax = delay;
+    }
+    bridge.lastStop = when;
+    bridge.transmitted++;
+}
+
+// Compares each replayed stop bit with the schedule, both relative to the
+// first word so the host link latency drops out
+static void ReplayTransmitted(simTime when) {
+    double error;
+
+    if (replay.transmitted >= replay.dueCount) {
+        return;
+    }
+    if (replay.transmitted == 0) {
+        replay.firstStop = when;
+    }
+    error = ((double)(when - replay.firstStop) - (double)(replay.due[replay.transmitted] - replay.due[0])) / SIM_CLOCKS_PER_US;
+    replay.errorSum += error < 0 ? -error : error;
+    if ((error < 0 ? -error : error) > replay.errorMax) {
+        replay.errorMax = error < 0 ? -error : error;
+    }
+    replay.transmitted++;
+}
+
+static void OnTransmit(unsigned char uart_index, unsigned int word, simTime when) {
+    if (uart_index == UART1_INDEX && replay.enabled) {
+        ReplayTransmitted(when);
+        return;
+    }
+    if (uart_index == UART1_INDEX && bridge.enabled) {
+        BridgeTransmitted(when);
+        return;
+    }
+    if (uart_index != HOST_UART_INDEX) {
+        return;
+    }
+    if (hostLog) {
+        fputc(word, hostLog);
+    }
+    capture.bytes++;
+    if (bridge.open) {
+        BridgeReceive((unsigned char)word, when);
+        return;
+    }
+    if (capture.length == 0 && word != HOST_SYNC) {
+        capture.syncErrors++;
+        return;
+    }
+    capture.packet[capture.length++] = (unsigned char)word;
+    if (capture.length >= 3 && capture.length == 3u + capture.packet[2] + 2) {
+        CapturePacket(capture.packet, capture.length);
+        capture.length = 0;
+    }
+}
+
+static void SendHostCommand(unsigned char type, const unsigned char* payload, unsigned char length) {
+    unsigned short crc = crc_update(crc_update(GALAXY_CRC_INITIAL, type), length);
+
+    SimLineSend(HOST_UART_INDEX, HOST_SYNC, 0);
+    SimLineSend(HOST_UART_INDEX, type, 0);
+    SimLineSend(HOST_UART_INDEX, length, 0);
+    for (unsigned char i=0; i < length; i++) {
+        crc = crc_update(crc, payload[i]);
+        SimLineSend(HOST_UART_INDEX, payload[i], 0);
+    }
+    SimLineSend(HOST_UART_INDEX, crc >> 8, 0);
+    SimLineSend(HOST_UART_INDEX, crc & 0xFF, 0);
+    hostCommands++;
+}
+
+// Packs as many words as credit and one packet allow into REPLAY_DATA.
+// Words are due one character time plus their gap after the previous one.
+static void ReplayFeed(unsigned long baud, double seconds) {
+    unsigned char payload[HOST_RX_PAYLOAD_SIZE];
+    unsigned char length = 0;
+    double wordUs = 1e6 * 11 / baud;
+
+    while (replay.credit != 0 && length + REPLAY_RECORD_MAX_SIZE <= HOST_RX_PAYLOAD_SIZE &&
+            replay.scheduleUs < seconds * 1e6) {
+        const stimulusWord* w = &traffic.words[trafficNext];
+        double next = replay.scheduleUs + w->gapUs + (trafficSent ? wordUs : 0);
+        // From the running total, so rounding does not add up over a long run
+        unsigned long delta = (unsigned long)(next * TIMESTAMP_TICKS_PER_US) -
+                              (unsigned long)(replay.scheduleUs * TIMESTAMP_TICKS_PER_US);
+        unsigned char deltaBytes = delta == 0 ? 0 : delta <= 0xFF ? 1 : delta <= 0xFFFF ? 2 : 3;
+
+        payload[length++] = (unsigned char)w->word;
+        payload[length++] = ((w->word >> 8) & 0x0F) | (deltaBytes << REPLAY_DELTA_SHIFT);
+        for (unsigned char k=0; k < deltaBytes; k++) {
+            payload[length++] = (unsigned char)(delta >> (8 * k));
+        }
+
+        replay.scheduleUs = next;
+        if (replay.dueCount == replay.dueCapacity) {
+            replay.dueCapacity = replay.dueCapacity ? replay.dueCapacity * 2 : 4096;
+            replay.due = realloc(replay.due, replay.dueCapacity * sizeof(*replay.due));
+        }
+        replay.due[replay.dueCount] = (replay.dueCount ? replay.due[replay.dueCount - 1] : 0) +
+                                      (unsigned long long)delta * (SIM_CLOCKS_PER_US / TIMESTAMP_TICKS_PER_US);
+        replay.dueCount++;
+
+        ReferenceWord(w->word);
+        trafficSent++;
+        trafficNext = (trafficNext + 1) % traffic.count;
+        replay.credit--;
+    }
+    if (length) {
+        SendHostCommand(HOST_COMMAND_REPLAY_DATA, payload, length);
+    }
+}
+
+// pin=word[/mask],... with xx for any word
+static int SendTrigger(const char* spec) {
+    unsigned char payload[3 + 4 * TRIGGER_MAX_LENGTH];
+    unsigned char count = 0;
+    char* end;
+    unsigned long pin = strtoul(spec, &end, 10);
+
+    if (*end != '=' || triggerCount == TRIGGER_MAX_PATTERNS) {
+        return -1;
+    }
+    do {
+        unsigned long value = 0;
+        unsigned long mask = TRIGGER_MASK_ALL;
+
+        if (count == TRIGGER_MAX_LENGTH) {
+            return -1;
+        }
+        spec = end + 1;
+        if (strncmp(spec, "xx", 2) == 0) {
+            mask = 0;
+            end = (char*)spec + 2;
+        } else {
+            value = strtoul(spec, &end, 16);
+            if (end == spec) {
+                return -1;
+            }
+        }
+        if (*end == '/') {
+            spec = end + 1;
+            mask = (strncmp(spec, "xx", 2) == 0) ? 0 : strtoul(spec, &end, 16);
+            if (mask == 0) {
+                end = (char*)spec + 2;
+            }
+        }
+        payload[3 + 4 * count] = value & 0xFF;
+        payload[4 + 4 * count] = value >> 8;
+        payload[5 + 4 * count] = mask & 0xFF;
+        payload[6 + 4 * count] = mask >> 8;
+        count++;
+    } while (*end == ',');
+    if (*end != '\0') {
+        return -1;
+    }
+
+    payload[0] = triggerCount++;
+    payload[1] = (unsigned char)pin;
+    payload[2] = count;
+    SendHostCommand(HOST_COMMAND_TRIGGER_SET, payload, 3 + 4 * count);
+    return 0;
+}
+
+// [h]address,...[/command,...]
+static int SendFilter(const char* spec) {
+    unsigned char payload[3 + 2 * 32];
+    unsigned char addresses = 0;
+    unsigned char commands = 0;
+    unsigned char list[2][32];
+    unsigned char which = 0;
+    char* end;
+
+    payload[0] = FILTER_MODE_ON;
+    if (*spec == 'h') {
+        payload[0] |= FILTER_MODE_HARDWARE;
+        spec++;
+    }
+    while (*spec) {
+        if (*spec == '/' && which == 0) {
+            which = 1;
+            spec++;
+            continue;
+        }
+        unsigned long value = strtoul(spec, &end, 16);
+        unsigned char* count = which ? &commands : &addresses;
+        if (end == spec || value > 0xFF || *count == 32) {
+            return -1;
+        }
+        list[which][(*count)++] = (unsigned char)value;
+        if (which) {
+            reference.commands[value] = 1;
+            reference.anyCommand = 0;
+        } else {
+            reference.addresses[value] = 1;
+            reference.anyAddress = 0;
+        }
+        spec = (*end == ',') ? end + 1 : end;
+    }
+
+    payload[1] = addresses;
+    memcpy(&payload[2], list[0], addresses);
+    payload[2 + addresses] = commands;
+    memcpy(&payload[3 + addresses], list[1], commands);
+    reference.enabled = 1;
+    SendHostCommand(HOST_COMMAND_FILTER_SET, payload, 3 + addresses + commands);
+    return 0;
+}
+
+static unsigned long Get16(const unsigned char* p) {
+    return p[0] | ((unsigned long)p[1] << 8);
+}
+
+static unsigned long Get32(const unsigned char* p) {
+    return Get16(p) | (Get16(p + 2) << 16);
+}
+
+static void PrintStats(void) {
+    const unsigned char* p = statsDump.last;
+
+    printf("stats         %lu dumps, last at tick %lu: %lu words, %lu frames, %lu CRC, %lu length, %lu fault\n",
+           statsDump.dumps, Get16(p), Get32(p + 2), Get32(p + 6), Get16(p + 10), Get16(p + 12), Get16(p + 14));
+    printf("              %lu framing, %lu overrun, %lu decoder dropped\n",
+           Get16(p + 16), Get16(p + 18), Get16(p + 20));
+    for (unsigned int x=0; x < FIFO_COUNT; x++) {
+        const unsigned char* fifo = p + 30 + x * STATS_FIFO_RECORD_SIZE;
+        printf("              FIFO %u peak %u, %lu failures, %lu words since the previous dump\n",
+               x, fifo[0], Get16(fifo + 1), Get32(fifo + 3));
+    }
+    p += 30 + FIFO_COUNT * STATS_FIFO_RECORD_SIZE;
+    printf("              %.1f%% idle since the previous dump\n", Get32(p) ? 100.0 * Get32(p + 4) / Get32(p) : 0.0);
+    printf("              frames by address since the previous dump");
+    for (unsigned int x=0; x < 256; x++) {
+        if (statsDump.lastAddresses[x]) {
+            printf(" %02X:%u%s", x, statsDump.lastAddresses[x],
+                   statsDump.lastAddresses[x] == STATS_ADDRESS_SATURATED ? "+" : "");
+        }
+    }
+    printf("\n");
+}
+
+// Timestamp units to microseconds
+static double ProfileUs(unsigned long units) {
+    return (double)units / TIMESTAMP_TICKS_PER_US;
+}
+
+static void PrintProfile(void) {
+    const unsigned char* p = profile.report;
+    double elapsed = Get32(p) ? (double)Get32(p) : 1.0;
+    unsigned char tasks = p[PROFILE_HEADER_SIZE - 1];
+
+    printf("profile       %.3f s window, %.1f%% idle\n", ProfileUs(Get32(p)) / 1e6, 100.0 * Get32(p + 4) / elapsed);
+    p += 8;
+    for (unsigned char x=0; x < 2; x++, p += PROFILE_ISR_RECORD_SIZE) {
+        printf("              %s %.1f%%, %lu entries, longest %.1f us\n", x ? "LowIsr " : "HighIsr",
+               100.0 * Get32(p) / elapsed, Get32(p + 4), ProfileUs(Get16(p + 8)));
+    }
+    printf("              entry latency %.1f us worst, RC1 read %.1f us after entry, %.1f us RC1IF wait in the model\n",
+           ProfileUs(Get16(p)), ProfileUs(Get16(p + 2)), (double)simStats[UART1_INDEX].rxWaitMax / SIM_CLOCKS_PER_US);
+    p += 5;
+    printf("              tasks");
+    for (unsigned char x=0; x < tasks; x++, p += PROFILE_TASK_RECORD_SIZE) {
+        printf(" %u:%.1f%%/%.1f", x, 100.0 * Get32(p) / elapsed, ProfileUs(Get16(p + 4)));
+    }
+    printf(" (load/longest us)\n");
+}
+
+static void Usage(void) {
+    fprintf(stderr, "usage: galaxysim [-t seconds] [-b baud] [-g gap_us] [-l loop_us] [-i isr_us]\n"
+                    "                 [-T pin=word[/mask],...] [-F [h]address,...[/command,...]]\n"
+                    "                 [-s ticks] [-r] [-o capture] [-B baud] [-a] [-X] [-p] [-v] [file]\n");
+    exit(2);
+}
+
+int main(int argc, char** argv) {
+    double seconds = 1.0;
+    unsigned long baud = UART_BAUD_19200;
+    double loopUs = 10.0;
+    double isrUs = 3.0;
+    double total;
+    unsigned long passes = 0;
+    unsigned long pulses[TRIGGER_PIN_COUNT] = { 0 };
+    unsigned char trigger = 0;
+    const char* triggers[TRIGGER_MAX_PATTERNS];
+    unsigned char triggerSpecs = 0;
+    const char* filter = NULL;
+    long statsTicks = -1;
+    unsigned long busBaud = 0;
+    unsigned char autoBaud = 0;
+    simTime start = 0;
+    simTime end;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "t:b:g:l:i:T:F:s:ro:B:aXpv")) != -1) {
+        switch (opt) {
+            case 't': seconds = atof(optarg); break;
+            case 'b': baud = strtoul(optarg, NULL, 10); break;
+            case 'g': frameGapUs = strtoul(optarg, NULL, 10); break;
+            case 'l': loopUs = atof(optarg); break;
+            case 'i': isrUs = atof(optarg); break;
+            case 'T':
+                if (triggerSpecs == TRIGGER_MAX_PATTERNS - 1) {
+                    Usage();
+                }
+                triggers[triggerSpecs++] = optarg;
+                break;
+            case 'F': filter = optarg; break;
+            case 's': statsTicks = strtol(optarg, NULL, 10); break;
+            case 'r': replay.enabled = 1; break;
+            case 'o':
+                if (!(hostLog = fopen(optarg, "wb"))) {
+                    perror(optarg);
+                    return 2;
+                }
+                break;
+            case 'B': busBaud = strtoul(optarg, NULL, 10); break;
+            case 'a': autoBaud = 1; break;
+            case 'X': bridge.enabled = 1; break;
+            case 'p': profile.enabled = 1; break;
+            case 'v': verbose = 1; break;
+            default: Usage();
+        }
+    }
+    if (bridge.enabled && (replay.enabled || autoBaud || filter || profile.enabled)) {
+        Usage();
+    }
+#if !PROFILE_ENABLED
+    if (profile.enabled) {
+        fprintf(stderr, "galaxysim: -p needs a build with DEFINES=-DPROFILE_ENABLED=TRUE\n");
+        return 2;
+    }
+#endif
+    if (optind < argc) {
+        if (StimulusLoad(&traffic, argv[optind]) != 0) {
+            return 2;
+        }
+    } else {
+        StimulusPollTraffic(&traffic, frameGapUs);
+    }
+
+    SimReset();
+    SimTxSink(OnTransmit);
+    SimLineConfigure(UART1_INDEX, baud, TRUE);
+    SimLineEcho(UART1_INDEX, TRUE);
+    SimLineConfigure(HOST_UART_INDEX, HOST_BAUD, FALSE);
+    simIsrClocks = (simTime)(isrUs * SIM_CLOCKS_PER_US);
+
+    AppInitialize();
+    for (unsigned char i=0; i < triggerSpecs; i++) {
+        if (SendTrigger(triggers[i]) != 0) {
+            fprintf(stderr, "bad trigger %s\n", triggers[i]);
+            return 2;
+        }
+    }
+    if (filter && SendFilter(filter) != 0) {
+        fprintf(stderr, "bad filter %s\n", filter);
+        return 2;
+    }
+    if (statsTicks >= 0) {
+        unsigned char period[2] = { (unsigned char)statsTicks, (unsigned char)(statsTicks >> 8) };
+        SendHostCommand(HOST_COMMAND_STATS, period, sizeof(period));
+    }
+    if (busBaud) {
+        unsigned char config[2] = { UART_BAUD_CODE_COUNT, UART_9BIT_MODE };
+        for (unsigned char code=0; code < UART_BAUD_CODE_COUNT; code++) {
+            if (busRates[code] == busBaud) {
+                config[0] = code;
+            }
+        }
+        if (config[0] == UART_BAUD_CODE_COUNT) {
+            fprintf(stderr, "no table rate %lu\n", busBaud);
+            return 2;
+        }
+        SendHostCommand(HOST_COMMAND_BUS_CONFIG, config, sizeof(config));
+    }
+    if (autoBaud) {
+        unsigned char config[2] = { BUS_BAUD_AUTO, UART_9BIT_MODE };
+        SendHostCommand(HOST_COMMAND_BUS_CONFIG, config, sizeof(config));
+        bus.detecting = 1;
+    }
+    if (bridge.enabled) {
+        bridge.wordClocks = (simTime)4 * (UART_SPBRG(busBaud ? busBaud : UART_BAUD_19200) + 1) * 11;
+        SendHostCommand(HOST_COMMAND_BRIDGE, NULL, 0);
+    }
+    if (replay.enabled) {
+        SendHostCommand(HOST_COMMAND_REPLAY_START, NULL, 0);
+        replay.credit = REPLAY_BUFFER_SIZE;
+    }
+
+    // Bus traffic starts once the host commands are in
+    if (hostCommands) {
+        start = SimLineIdleAt(HOST_UART_INDEX) + (simTime)1000 * SIM_CLOCKS_PER_US;
+    }
+
+    end = (simTime)(seconds * _XTAL_FREQ);
+    while (simNow < end + (simTime)DRAIN_US * SIM_CLOCKS_PER_US) {
+        if (bus.detecting && bus.resume && simNow >= bus.resume) {
+            bus.detecting = 0;
+        }
+        if (bus.detecting && bus.resume) {
+            // Quiet line until the lock has settled
+        } else if (bridge.enabled) {
+            // Leave once everything has come back, or the drain time is half gone
+            if (bridge.open && !bridge.exitSent && simNow < end) {
+                BridgeFeed();
+            } else if (bridge.open && !bridge.exitSent &&
+                    (capture.records >= sentCount || simNow >= end + (simTime)DRAIN_US * SIM_CLOCKS_PER_US / 2)) {
+                BridgeSend(BRIDGE_ESCAPE);
+                BridgeSend(BRIDGE_CODE_EXIT);
+                bridge.exitSent = 1;
+            }
+        } else if (replay.enabled) {
+            if (simNow >= start && SimLineIdleAt(HOST_UART_INDEX) <= simNow) {
+                ReplayFeed(baud, seconds);
+            }
+        } else while (simNow >= start && simNow < end && SimLineSpace(UART1_INDEX) != 0 &&
+                SimLineIdleAt(UART1_INDEX) < simNow + (simTime)LOOKAHEAD_US * SIM_CLOCKS_PER_US &&
+                SimLineIdleAt(UART1_INDEX) < end) {
+            SendNextWord();
+        }
+        if (profile.enabled && !profile.requested && simNow >= end + (simTime)DRAIN_US * SIM_CLOCKS_PER_US / 2) {
+            SendHostCommand(HOST_COMMAND_PROFILE, NULL, 0);
+            profile.requested = 1;
+        }
+        AppService();
+        // Interrupts preempt the pass, to the microsecond
+        for (simTime left = (simTime)(loopUs * SIM_CLOCKS_PER_US); left != 0; ) {
+            simTime step = left < SIM_CLOCKS_PER_US ? left : SIM_CLOCKS_PER_US;
+            SimAdvance(step);
+            SimDispatchInterrupts();
+            left -= step;
+        }
+        passes++;
+
+        // DIG_OUT_12..14 are RB2..RB4
+        for (unsigned char pin=0; pin < TRIGGER_PIN_COUNT; pin++) {
+            unsigned char bit = 1 << (pin + 2);
+            if ((LATB & bit) && !(trigger & bit)) {
+                pulses[pin]++;
+            }
+        }
+        trigger = LATB;
+    }
+
+    ReferenceFrameEnd();
+    if (hostLog) {
+        fclose(hostLog);
+    }
+    total = (double)simNow / _XTAL_FREQ;
+    printf("simulated     %.3f s of traffic, %.3f s total, %lu main loop passes\n", seconds, total, passes);
+    printf("bus           %zu words sent at %lu baud\n", trafficSent, baud);
+    if (bus.reports) {
+        const unsigned char* r = bus.report;
+        printf("bus config    %s at %lu baud, %s mode, shortest ABD count %u\n",
+               r[2] == BUS_STATE_LOCKED ? "locked" : r[2] == BUS_STATE_NO_LOCK ? "no lock, kept" :
+               r[2] == BUS_STATE_DETECTING ? "detecting" : "set",
+               r[0] < UART_BAUD_CODE_COUNT ? busRates[r[0]] : 0, r[1] == UART_9BIT_MODE ? "9 bit" : "8 bit",
+               r[3] | (r[4] << 8));
+        printf("              %zu words sent while detecting, %lu records discarded\n",
+               bus.trainingWords, bus.discarded);
+    }
+    printf("UART1         %lu received, %lu ignored, %lu overruns, %lu framing errors\n",
+           simStats[UART1_INDEX].received, simStats[UART1_INDEX].ignored,
+           simStats[UART1_INDEX].overruns, simStats[UART1_INDEX].framingErrors);
+    printf("filter        %lu words expected, %lu dropped in firmware\n", (unsigned long)sentCount, filterDropped);
+    printf("firmware      %u double reads, %u capture packets dropped, %.1f%% idle\n", rxOverrunsAvoided,
+           captureDroppedPackets, 100.0 * simSleepClocks / simNow);
+    for (unsigned char x=0; x < FIFO_COUNT; x++) {
+        fifoStats fifo;
+        FifoStatsSnapshot(&buffers[x], &fifo, FALSE);
+        printf("FIFO %u        peak %u, %u failures, %lu words\n", x, fifo.peak, fifo.failures, fifo.total);
+    }
+    printf("capture       %lu records in %lu packets, %lu sequence gaps, %lu CRC errors, %lu mismatches\n",
+           capture.records, capture.packets, capture.sequenceGaps, capture.crcErrors, capture.mismatches);
+    printf("UART2         %lu bytes, %.1f%% of line time\n", capture.bytes,
+           100.0 * capture.bytes * 10 / (total * HOST_BAUD));
+    printf("host link     %lu commands acknowledged, %lu failed\n", capture.acks, capture.nacks);
+    printf("triggers     ");
+    for (unsigned char pin=0; pin < TRIGGER_PIN_COUNT; pin++) {
+        printf(" DIG_OUT_%u %lu%s", TRIGGER_PIN_FIRST + pin, pulses[pin], pin + 1 < TRIGGER_PIN_COUNT ? "," : " pulses\n");
+    }
+    if (statsDump.dumps) {
+        PrintStats();
+    }
+    if (profile.reports) {
+        PrintProfile();
+    }
+    if (replay.enabled) {
+        printf("replay        %zu of %zu words on the wire, %lu credited, %lu underruns, %lu late\n",
+               replay.transmitted, replay.dueCount, replay.credited, replay.underruns, replay.late);
+        printf("              gap error %.1f us mean, %.1f us max\n",
+               replay.transmitted ? replay.errorSum / replay.transmitted : 0.0, replay.errorMax);
+    }
+
+    if (bridge.enabled) {
+        printf("bridge        %zu of %zu words on the wire, %lu credited, %lu faults, %u + %u dropped in firmware\n",
+               bridge.transmitted, bridge.arrivedCount, bridge.credited, bridge.faults,
+               bridgeHostDropped, bridgeDeviceDropped);
+        printf("              forwarding delay %.1f us mean, %.1f us max\n",
+               bridge.transmitted ? bridge.delaySum / bridge.transmitted : 0.0, bridge.delayMax);
+    }
+
+    if (capture.nacks || capture.acks != hostCommands) {
+        printf("result        HOST COMMANDS FAILED\n");
+        return 1;
+    }
+    if (profile.enabled && !profile.reports) {
+        printf("result        NO PROFILE REPORT\n");
+        return 1;
+    }
+    if (autoBaud && (!bus.reports || bus.report[2] != BUS_STATE_LOCKED || busRates[bus.report[0]] != baud)) {
+        printf("result        AUTO-BAUD FAILED\n");
+        return 1;
+    }
+    if (capture.records != sentCount || capture.mismatches || capture.sequenceGaps || capture.crcErrors) {
+        printf("result        LOST WORDS\n");
+        return 1;
+    }
+    if (bridge.enabled && (!bridge.closed || bridge.transmitted != bridge.arrivedCount)) {
+        printf("result        BRIDGE INCOMPLETE\n");
+        return 1;
+    }
+    if (replay.enabled && replay.transmitted != replay.dueCount) {
+        printf("result        REPLAY INCOMPLETE\n");
+        return 1;
+    }
+    printf("result        lossless\n");
+    return 0;
+}
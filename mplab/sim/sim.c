@@ -0,0 +1,601 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <xc.h>
+#include "app.h"
+#include "sim.h"
+
+volatile unsigned char LATA, LATB, LATC, TRISA, TRISB, TRISC, PORTA, PORTB, PORTC;
+volatile unsigned char ANSELA, ANSELB, ANSELC;
+volatile unsigned char BAUDCON1, BAUDCON2, SPBRG1, SPBRGH1, SPBRG2, SPBRGH2;
+volatile unsigned char PIR1, PIE1, IPR1, PIR3, PIE3, IPR3, PIR5, PIE5, IPR5;
+volatile unsigned char INTCON, INTCON2, RCON;
+volatile unsigned char T0CON, TMR0H, TMR0L, T1CON, T1GCON, TMR1H, TMR1L;
+volatile unsigned char T2CON, TMR2, PR2;
+volatile unsigned char T4CON, TMR4, PR4;
+volatile unsigned char CCP1CON, CCPR1L, CCPR1H, CCPTMRS0;
+volatile unsigned char OSCCON, OSCCON2, OSCTUNE;
+
+simTime simNow;
+simTime simIsrClocks;
+simTime simSleepClocks;
+simUartStats simStats[SIM_UART_COUNT];
+
+typedef struct {
+    unsigned int word;
+    simTime done;                           // Stop bit time
+} simLineWord;
+
+typedef struct {
+    // Registers
+    volatile unsigned char rcsta;
+    volatile unsigned char txsta;
+    volatile unsigned char txreg;
+
+    // Far end of the line
+    unsigned long lineBaud;
+    unsigned char lineBits9;
+    unsigned char echo;
+    simLineWord line[SIM_LINE_QUEUE_SIZE];
+    unsigned int lineRead;
+    unsigned int lineWrite;
+    simTime lineIdle;
+    simLineWord echoed[SIM_RX_FIFO_DEPTH + 1];
+    unsigned char echoCount;
+
+    // Receiver
+    unsigned int rxFifo[SIM_RX_FIFO_DEPTH];
+    unsigned char rxCount;
+    simTime rxTop;                          // When rxFifo[0] reached the top
+
+    // Auto-baud detect
+    unsigned char abdEdges;                 // Rising edges seen since ABDEN
+    simTime abdFirst;                       // First rising edge
+
+    // Transmitter
+    unsigned char txPending;                // TXREG written, not yet in the TSR
+    unsigned char txNinth;                  // TX9D when TXREG was written
+    unsigned char txBusy;                   // TSR shifting
+    unsigned int txShift;
+    simTime txDone;
+} simUart;
+
+static simUart uarts[SIM_UART_COUNT];
+static simTxSink txSink;
+static simTime timer0Clocks;
+static simTime timer1Clocks;
+
+// Timer2 and Timer4 share one model, T4CON has the T2CON layout
+typedef struct {
+    volatile unsigned char* con;
+    volatile unsigned char* tmr;
+    volatile unsigned char* pr;
+    simTime clocks;
+    unsigned char matches;                  // Since the last postscaled TMRxIF
+} simPeriodTimer;
+
+static simPeriodTimer timer2 = { &T2CON, &TMR2, &PR2 };
+static simPeriodTimer timer4 = { &T4CON, &TMR4, &PR4 };
+
+void SimReset(void) {
+    for (unsigned char i=0; i < SIM_UART_COUNT; i++) {
+        simUart* u = &uarts[i];
+        u->rcsta = 0;
+        u->txsta = 0x02;                    // TRMT
+        u->lineRead = u->lineWrite = 0;
+        u->lineIdle = 0;
+        u->echoCount = 0;
+        u->rxCount = 0;
+        u->abdEdges = 0;
+        u->txPending = u->txBusy = 0;
+        u->lineBaud = 19200;
+        u->lineBits9 = 1;
+        u->echo = 0;
+        simStats[i] = (simUartStats){0};
+    }
+    LATA = LATB = LATC = 0;
+    TRISA = TRISB = TRISC = 0xFF;
+    PIR1 = PIE1 = PIR3 = PIE3 = PIR5 = PIE5 = 0;
+    IPR1 = IPR3 = IPR5 = 0xFF;
+    INTCON = 0;
+    INTCON2 = 0xFF;
+    RCON = 0x1C;
+    T0CON = 0xFF;
+    T1CON = 0;
+    T2CON = T4CON = 0;
+    TMR0H = TMR0L = TMR1H = TMR1L = TMR2 = TMR4 = 0;
+    PR2 = PR4 = 0xFF;
+    CCP1CON = CCPR1L = CCPR1H = CCPTMRS0 = 0;
+    BAUDCON1 = BAUDCON2 = 0;
+    OSCCON = 0x3C;                          // HFINTOSC stable
+    OSCCON2 = 0x84;                         // PLL locked
+    simNow = 0;
+    simSleepClocks = 0;
+    timer0Clocks = timer1Clocks = 0;
+    timer2.clocks = timer4.clocks = 0;
+    timer2.matches = timer4.matches = 0;
+}
+
+//===============================================================================
+//	UART model
+//===============================================================================
+
+static volatile __BAUDCONbits_t* SimBaudcon(unsigned char uart_index) {
+    return (uart_index == 1) ? &BAUDCON1bits : &BAUDCON2bits;
+}
+
+// FOSC clocks per baud rate generator count
+static unsigned int SimBrgDivider(unsigned char uart_index) {
+    unsigned char brg16 = SimBaudcon(uart_index)->BRG16;
+    unsigned char brgh = ((volatile __TXSTAbits_t*)&uarts[uart_index].txsta)->BRGH;
+    return (brg16 && brgh) ? 4 : ((brg16 || brgh) ? 16 : 64);
+}
+
+static simTime SimBitClocks(unsigned char uart_index) {
+    unsigned char brg16 = SimBaudcon(uart_index)->BRG16;
+    unsigned int spbrg = (uart_index == 1) ? (SPBRG1 | (brg16 ? (unsigned int)SPBRGH1 << 8 : 0))
+                                           : (SPBRG2 | (brg16 ? (unsigned int)SPBRGH2 << 8 : 0));
+    return (simTime)SimBrgDivider(uart_index) * (spbrg + 1);
+}
+
+static unsigned char SimWordBits(unsigned char bits9) {
+    return bits9 ? 11 : 10;                 // Start, data, stop
+}
+
+static void SimRxFlags(unsigned char uart_index) {
+    simUart* u = &uarts[uart_index];
+    volatile __RCSTAbits_t* rcsta = (volatile __RCSTAbits_t*)&u->rcsta;
+    unsigned char pending = (u->rxCount != 0);
+
+    // RX9D and FERR always describe the word at the top of the FIFO
+    rcsta->RX9D = pending && (u->rxFifo[0] & 0x100) && rcsta->RX9;
+    rcsta->FERR = pending && (u->rxFifo[0] & SIM_LINE_FRAMING_ERROR);
+    if (uart_index == 1) {
+        PIR1bits.RC1IF = pending;
+    } else {
+        PIR3bits.RC2IF = pending;
+    }
+}
+
+// ABD counts the BRG clock times 8 from the first rising edge on RX to the
+// fifth, 8 bit times for 0x55 and longer for anything else. The count
+// lands in SPBRGH:SPBRG, ABDEN clears and RCIF is set on a junk byte.
+// Words are taken apart into their edges at the line rate.
+static void SimAutoBaudWord(unsigned char uart_index, unsigned int word, simTime done) {
+    simUart* u = &uarts[uart_index];
+    volatile __BAUDCONbits_t* baudcon = SimBaudcon(uart_index);
+    unsigned char bits = SimWordBits(u->lineBits9);
+    double bit = (double)_XTAL_FREQ / u->lineBaud;
+    double start = (double)done - bits * bit;
+    unsigned int clock = 8 * SimBrgDivider(uart_index);
+    unsigned char previous = 0;             // Start bit
+
+    simStats[uart_index].ignored++;
+    for (unsigned char k=1; k < bits; k++) {
+        unsigned char level = (k == bits - 1) ? 1 : (word >> (k - 1)) & 1;
+        simTime edge = (simTime)(start + k * bit);
+        unsigned long long count;
+
+        if (!previous && level) {
+            if (u->abdEdges == 0) {
+                u->abdFirst = edge;
+            }
+            u->abdEdges++;
+            count = (edge - u->abdFirst) / clock;
+            if (count > 0xFFFF) {
+                baudcon->ABDOVF = 1;
+                u->abdEdges = 0;
+            } else if (u->abdEdges == 5) {
+                if (uart_index == 1) {
+                    SPBRGH1 = (unsigned char)(count >> 8);
+                    SPBRG1 = (unsigned char)count;
+                } else {
+                    SPBRGH2 = (unsigned char)(count >> 8);
+                    SPBRG2 = (unsigned char)count;
+                }
+                baudcon->ABDEN = 0;
+                u->abdEdges = 0;
+                if (u->rxCount == 0) {
+                    u->rxTop = edge;
+                }
+                if (u->rxCount < SIM_RX_FIFO_DEPTH) {
+                    u->rxFifo[u->rxCount++] = 0;
+                }
+                SimRxFlags(uart_index);
+                return;
+            }
+        }
+        previous = level;
+    }
+}
+
+static void SimRxDeliver(unsigned char uart_index, unsigned int word, simTime done) {
+    simUart* u = &uarts[uart_index];
+    volatile __RCSTAbits_t* rcsta = (volatile __RCSTAbits_t*)&u->rcsta;
+    unsigned long lineBaud = u->lineBaud;
+    unsigned long rxBaud = _XTAL_FREQ / SimBitClocks(uart_index);
+
+    if (!rcsta->SPEN || !rcsta->CREN) {
+        simStats[uart_index].ignored++;
+        return;
+    }
+    if (SimBaudcon(uart_index)->ABDEN) {
+        SimAutoBaudWord(uart_index, word, done);
+        return;
+    }
+    // Address detect: only words with the 9th bit set are loaded
+    if (rcsta->ADDEN && rcsta->RX9 && !(word & 0x100)) {
+        simStats[uart_index].ignored++;
+        return;
+    }
+    // The receiver stops while OERR is set
+    if (rcsta->OERR || u->rxCount == SIM_RX_FIFO_DEPTH) {
+        rcsta->OERR = 1;
+        simStats[uart_index].overruns++;
+        return;
+    }
+    if ((lineBaud > rxBaud ? lineBaud - rxBaud : rxBaud - lineBaud) * 100 > rxBaud * SIM_BAUD_TOLERANCE_PERCENT) {
+        word |= SIM_LINE_FRAMING_ERROR;
+    }
+    if (word & SIM_LINE_FRAMING_ERROR) {
+        simStats[uart_index].framingErrors++;
+    }
+    if (u->rxCount == 0) {
+        u->rxTop = done;
+    }
+    u->rxFifo[u->rxCount++] = word;
+    simStats[uart_index].received++;
+    SimRxFlags(uart_index);
+}
+
+static void SimTxFlags(unsigned char uart_index) {
+    simUart* u = &uarts[uart_index];
+    volatile __TXSTAbits_t* txsta = (volatile __TXSTAbits_t*)&u->txsta;
+    unsigned char empty = txsta->TXEN && !u->txPending;
+
+    txsta->TRMT = !u->txBusy;
+    if (uart_index == 1) {
+        PIR1bits.TX1IF = empty;
+    } else {
+        PIR3bits.TX2IF = empty;
+    }
+}
+
+// TXREG moves to the TSR as soon as the TSR is free
+static void SimTxLoad(unsigned char uart_index, simTime when) {
+    simUart* u = &uarts[uart_index];
+    volatile __TXSTAbits_t* txsta = (volatile __TXSTAbits_t*)&u->txsta;
+
+    if (u->txPending && !u->txBusy && txsta->TXEN) {
+        u->txShift = u->txreg | (u->txNinth ? 0x100 : 0);
+        u->txPending = 0;
+        u->txBusy = 1;
+        u->txDone = when + SimBitClocks(uart_index) * SimWordBits(txsta->TX9);
+    }
+    SimTxFlags(uart_index);
+}
+
+static void SimUartAdvance(unsigned char uart_index, simTime until) {
+    simUart* u = &uarts[uart_index];
+
+    while (1) {
+        simTime next = until + 1;
+        unsigned char source = 0;
+
+        if (u->lineRead != u->lineWrite && u->line[u->lineRead].done <= until) {
+            next = u->line[u->lineRead].done;
+            source = 1;
+        }
+        if (u->echoCount && u->echoed[0].done < next) {
+            next = u->echoed[0].done;
+            source = 2;
+        }
+        if (u->txBusy && u->txDone < next) {
+            next = u->txDone;
+            source = 3;
+        }
+        if (next > until) {
+            return;
+        }
+
+        if (source == 1) {
+            SimRxDeliver(uart_index, u->line[u->lineRead].word, next);
+            u->lineRead = (u->lineRead + 1) % SIM_LINE_QUEUE_SIZE;
+        } else if (source == 2) {
+            SimRxDeliver(uart_index, u->echoed[0].word, next);
+            u->echoCount--;
+            for (unsigned char i=0; i < u->echoCount; i++) {
+                u->echoed[i] = u->echoed[i+1];
+            }
+        } else {
+            u->txBusy = 0;
+            simStats[uart_index].transmitted++;
+            if (u->echo && u->echoCount <= SIM_RX_FIFO_DEPTH) {
+                u->echoed[u->echoCount].word = u->txShift & 0x1FF;
+                u->echoed[u->echoCount].done = u->txDone;
+                u->echoCount++;
+            }
+            if (txSink) {
+                txSink(uart_index, u->txShift & 0x1FF, u->txDone);
+            }
+            SimTxLoad(uart_index, u->txDone);
+        }
+    }
+}
+
+volatile __RCSTAbits_t* SimRcsta(unsigned char uart_index) {
+    simUart* u = &uarts[uart_index];
+    volatile __RCSTAbits_t* rcsta = (volatile __RCSTAbits_t*)&u->rcsta;
+
+    // Clearing CREN resets the receiver and OERR with it
+    if (!rcsta->CREN) {
+        rcsta->OERR = 0;
+    }
+    if (!rcsta->SPEN) {
+        u->rxCount = 0;
+        SimRxFlags(uart_index);
+    }
+    return rcsta;
+}
+
+volatile __TXSTAbits_t* SimTxsta(unsigned char uart_index) {
+    SimTxLoad(uart_index, simNow);
+    return (volatile __TXSTAbits_t*)&uarts[uart_index].txsta;
+}
+
+unsigned char SimUartRead(unsigned char uart_index) {
+    simUart* u = &uarts[uart_index];
+    unsigned int word;
+
+    if (u->rxCount == 0) {
+        return 0;
+    }
+    word = u->rxFifo[0];
+    if (simNow - u->rxTop > simStats[uart_index].rxWaitMax) {
+        simStats[uart_index].rxWaitMax = simNow - u->rxTop;
+    }
+    u->rxCount--;
+    for (unsigned char i=0; i < u->rxCount; i++) {
+        u->rxFifo[i] = u->rxFifo[i+1];
+    }
+    u->rxTop = simNow;
+    SimRxFlags(uart_index);
+    return (unsigned char)word;
+}
+
+// The byte lands in TXREG after this returns, so it is picked up on the
+// next SimAdvance or TXSTA access
+volatile unsigned char* SimUartWrite(unsigned char uart_index) {
+    simUart* u = &uarts[uart_index];
+    volatile __TXSTAbits_t* txsta = (volatile __TXSTAbits_t*)&u->txsta;
+
+    SimTxLoad(uart_index, simNow);
+    u->txPending = 1;
+    u->txNinth = txsta->TX9D;
+    SimTxFlags(uart_index);
+    return &u->txreg;
+}
+
+//===============================================================================
+//	Line model
+//===============================================================================
+
+void SimLineConfigure(unsigned char uart_index, unsigned long baud, unsigned char bits9) {
+    uarts[uart_index].lineBaud = baud;
+    uarts[uart_index].lineBits9 = bits9;
+}
+
+// Loop transmitted words back into the receiver, like an RS-485 transceiver
+// with its receiver enabled
+void SimLineEcho(unsigned char uart_index, unsigned char enable) {
+    uarts[uart_index].echo = enable;
+}
+
+unsigned int SimLineSpace(unsigned char uart_index) {
+    simUart* u = &uarts[uart_index];
+    return SIM_LINE_QUEUE_SIZE - 1 - ((u->lineWrite - u->lineRead + SIM_LINE_QUEUE_SIZE) % SIM_LINE_QUEUE_SIZE);
+}
+
+// Queues a word from the far end, starting GAP clocks after the line goes
+// idle. Returns the stop bit time.
+simTime SimLineSend(unsigned char uart_index, unsigned int word, simTime gap) {
+    simUart* u = &uarts[uart_index];
+    simTime start = (u->lineIdle > simNow ? u->lineIdle : simNow) + gap;
+
+    if (SimLineSpace(uart_index) == 0) {
+        fprintf(stderr, "sim: line queue full on UART%u\n", uart_index);
+        exit(2);
+    }
+    u->lineIdle = start + (simTime)(_XTAL_FREQ / u->lineBaud) * SimWordBits(u->lineBits9);
+    u->line[u->lineWrite].word = word;
+    u->line[u->lineWrite].done = u->lineIdle;
+    u->lineWrite = (u->lineWrite + 1) % SIM_LINE_QUEUE_SIZE;
+    return u->lineIdle;
+}
+
+// Puts a word straight into the receive FIFO, no line time
+void SimRxInject(unsigned char uart_index, unsigned int word) {
+    SimRxDeliver(uart_index, word, simNow);
+}
+
+simTime SimLineIdleAt(unsigned char uart_index) {
+    return uarts[uart_index].lineIdle;
+}
+
+void SimTxSink(simTxSink sink) {
+    txSink = sink;
+}
+
+//===============================================================================
+//	Timers
+//===============================================================================
+
+static void SimTimer0(simTime clocks) {
+    unsigned long prescale = T0CONbits.PSA ? 1 : (2UL << T0CONbits.T0PS);
+    unsigned long period = 4 * prescale;
+    unsigned long count;
+    unsigned long limit = T0CONbits.T08BIT ? 0x100 : 0x10000;
+    unsigned long value = T0CONbits.T08BIT ? TMR0L : ((unsigned long)TMR0H << 8) | TMR0L;
+
+    if (!T0CONbits.TMR0ON) {
+        return;
+    }
+    timer0Clocks += clocks;
+    count = (unsigned long)(timer0Clocks / period);
+    timer0Clocks %= period;
+    if (value + count >= limit) {
+        INTCONbits.TMR0IF = 1;
+    }
+    value = (value + count) % limit;
+    TMR0L = (unsigned char)value;
+    if (!T0CONbits.T08BIT) {
+        TMR0H = (unsigned char)(value >> 8);
+    }
+}
+
+static void SimTimer1(simTime clocks) {
+    unsigned long period = (T1CONbits.TMR1CS == 1 ? 1 : 4) << T1CONbits.T1CKPS;
+    unsigned long count;
+    unsigned long value = ((unsigned long)TMR1H << 8) | TMR1L;
+
+    if (!T1CONbits.TMR1ON) {
+        return;
+    }
+    timer1Clocks += clocks;
+    count = (unsigned long)(timer1Clocks / period);
+    timer1Clocks %= period;
+    if (value + count >= 0x10000) {
+        PIR1bits.TMR1IF = 1;
+    }
+
+    // CCP1 compare modes raise CCP1IF as TMR1 counts onto CCPR1. Only
+    // Timer1 as the CCP1 timebase is modelled.
+    if ((CCP1CON & 0x0C) == 0x08 && CCPTMRS0bits.C1TSEL == 0 && count != 0) {
+        unsigned long compare = ((unsigned long)CCPR1H << 8) | CCPR1L;
+        if (((compare - value - 1) & 0xFFFF) < count) {
+            PIR1bits.CCP1IF = 1;
+        }
+    }
+    value = (value + count) & 0xFFFF;
+    TMR1L = (unsigned char)value;
+    TMR1H = (unsigned char)(value >> 8);
+}
+
+// TMRx counts up to PRx and clears on the next count, the match. TRUE
+// when that raises TMRxIF, every T2OUTPS + 1 matches. Written above PRx,
+// it runs on to 0xFF and wraps without a match first.
+static unsigned char SimPeriodTimer(simPeriodTimer* t, simTime clocks) {
+    volatile __T2CONbits_t* con = (volatile __T2CONbits_t*)t->con;
+    unsigned long period = 4 * (con->T2CKPS == 0 ? 1 : con->T2CKPS == 1 ? 4 : 16);
+    unsigned char raised = FALSE;
+    unsigned long count;
+
+    if (!con->TMR2ON) {
+        return FALSE;
+    }
+    t->clocks += clocks;
+    count = (unsigned long)(t->clocks / period);
+    t->clocks %= period;
+    while (count != 0) {
+        unsigned int toMatch = (*t->tmr <= *t->pr ? *t->pr : 0x100 + *t->pr) - *t->tmr + 1;
+        if (count < toMatch) {
+            *t->tmr = (unsigned char)(*t->tmr + count);
+            break;
+        }
+        count -= toMatch;
+        *t->tmr = 0;
+        if (t->matches++ == con->T2OUTPS) {
+            t->matches = 0;
+            raised = TRUE;
+        }
+    }
+    return raised;
+}
+
+void SimAdvance(simTime clocks) {
+    simTime until = simNow + clocks;
+
+    for (unsigned char i=1; i < SIM_UART_COUNT; i++) {
+        // Clearing ABDEN abandons a measurement
+        if (!SimBaudcon(i)->ABDEN) {
+            uarts[i].abdEdges = 0;
+        }
+        SimTxLoad(i, simNow);
+        SimUartAdvance(i, until);
+    }
+    SimTimer0(clocks);
+    SimTimer1(clocks);
+    if (SimPeriodTimer(&timer2, clocks)) {
+        PIR1bits.TMR2IF = 1;
+    }
+    if (SimPeriodTimer(&timer4, clocks)) {
+        PIR5bits.TMR4IF = 1;
+    }
+    simNow = until;
+}
+
+//===============================================================================
+//	Interrupt controller
+//===============================================================================
+
+// WAKE asks whether SLEEP would end, which any enabled source does with
+// the global enables clear
+static unsigned char SimRequest(unsigned char high, unsigned char wake) {
+    unsigned char ipen = RCONbits.IPEN;
+
+    if (wake) {
+        ipen = FALSE;
+        high = TRUE;
+    } else if (!INTCONbits.GIEH) {
+        return FALSE;
+    }
+    if (!ipen && !high) {
+        return FALSE;                       // Everything vectors high
+    }
+    if (ipen && !high && !INTCONbits.GIEL) {
+        return FALSE;
+    }
+
+#define SIM_SOURCE(flag, enable, priority, peripheral) \
+    if ((flag) && (enable) && (wake || (ipen ? ((priority) == high) : (!(peripheral) || INTCONbits.PEIE)))) return TRUE;
+
+    SIM_SOURCE(INTCONbits.TMR0IF, INTCONbits.TMR0IE, INTCON2bits.TMR0IP, 0)
+    SIM_SOURCE(PIR1bits.TMR1IF, PIE1bits.TMR1IE, IPR1bits.TMR1IP, 1)
+    SIM_SOURCE(PIR1bits.CCP1IF, PIE1bits.CCP1IE, IPR1bits.CCP1IP, 1)
+    SIM_SOURCE(PIR1bits.TMR2IF, PIE1bits.TMR2IE, IPR1bits.TMR2IP, 1)
+    SIM_SOURCE(PIR5bits.TMR4IF, PIE5bits.TMR4IE, IPR5bits.TMR4IP, 1)
+    SIM_SOURCE(PIR1bits.RC1IF, PIE1bits.RC1IE, IPR1bits.RC1IP, 1)
+    SIM_SOURCE(PIR1bits.TX1IF, PIE1bits.TX1IE, IPR1bits.TX1IP, 1)
+    SIM_SOURCE(PIR3bits.RC2IF, PIE3bits.RC2IE, IPR3bits.RC2IP, 1)
+    SIM_SOURCE(PIR3bits.TX2IF, PIE3bits.TX2IE, IPR3bits.TX2IP, 1)
+
+#undef SIM_SOURCE
+    return FALSE;
+}
+
+// Runs ISRs until nothing is pending. Each entry costs simIsrClocks.
+void SimDispatchInterrupts(void) {
+    for (unsigned int n=0; n < SIM_INTERRUPT_STORM; n++) {
+        if (SimRequest(TRUE, FALSE)) {
+            HighIsr();
+        } else if (SimRequest(FALSE, FALSE)) {
+            LowIsr();
+        } else {
+            return;
+        }
+        SimAdvance(simIsrClocks);
+    }
+    fprintf(stderr, "sim: interrupt flag never cleared\n");
+    exit(2);
+}
+
+// SLEEP and idle: time passes until an enabled interrupt is pending, or
+// SIM_SLEEP_LIMIT_US so a missing wake source cannot hang the simulation
+void SimSleep(void) {
+    for (unsigned long us=0; us < SIM_SLEEP_LIMIT_US; us++) {
+        if (SimRequest(TRUE, TRUE)) {
+            return;
+        }
+        SimAdvance(SIM_CLOCKS_PER_US);
+        simSleepClocks += SIM_CLOCKS_PER_US;
+    }
+}
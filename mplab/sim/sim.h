@@ -0,0 +1,69 @@
+/* 
+ * File:   sim.h
+ *
+ * Host model of the PIC18LF26K22 peripherals the firmware uses: both
+ * EUSARTs with a line model on each, Timer0, Timer1 with CCP1 compare,
+ * Timer2, Timer4 and the two-level interrupt controller. Time is counted in FOSC clocks and only moves when
+ * SimAdvance() is called, so firmware code between two calls runs in zero
+ * simulated time.
+ */
+
+#ifndef SIM_H
+#define	SIM_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#define SIM_UART_COUNT              3       // Indexed by UART1_INDEX, UART2_INDEX
+#define SIM_LINE_QUEUE_SIZE         1024
+#define SIM_RX_FIFO_DEPTH           2
+#define SIM_BAUD_TOLERANCE_PERCENT  3       // Line and BRG further apart than this give FERR
+#define SIM_INTERRUPT_STORM         1000
+#define SIM_SLEEP_LIMIT_US          1000000UL
+
+#define SIM_CLOCKS_PER_US           (_XTAL_FREQ / 1000000UL)
+#define SIM_LINE_FRAMING_ERROR      0x0200  // Word flag: deliver with FERR set
+
+typedef unsigned long long simTime;
+
+typedef struct {
+    unsigned long received;                 // Words into the receive FIFO
+    unsigned long overruns;                 // Words lost to a full receive FIFO
+    unsigned long ignored;                  // Receiver off, or ADDEN and not an address
+    unsigned long framingErrors;
+    unsigned long transmitted;              // Stop bits sent
+    simTime rxWaitMax;                      // Longest RCIF wait before RCREG was read
+} simUartStats;
+
+typedef void (*simTxSink)(unsigned char uart_index, unsigned int word, simTime when);
+
+extern simTime simNow;
+extern simTime simIsrClocks;                // Charged per ISR entry
+extern simTime simSleepClocks;              // Spent in SLEEP or IDLE
+extern simUartStats simStats[SIM_UART_COUNT];
+
+void SimReset(void);
+void SimAdvance(simTime clocks);
+void SimDispatchInterrupts(void);
+
+void SimLineConfigure(unsigned char uart_index, unsigned long baud, unsigned char bits9);
+void SimLineEcho(unsigned char uart_index, unsigned char enable);
+unsigned int SimLineSpace(unsigned char uart_index);
+simTime SimLineSend(unsigned char uart_index, unsigned int word, simTime gap);
+simTime SimLineIdleAt(unsigned char uart_index);
+void SimRxInject(unsigned char uart_index, unsigned int word);
+void SimTxSink(simTxSink sink);
+
+// Firmware entry points, from main.c
+void AppInitialize(void);
+void AppService(void);
+void HighIsr(void);
+void LowIsr(void);
+
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* SIM_H */
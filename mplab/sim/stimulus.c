@@ -0,0 +1,90 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "app.h"
+#include "galaxy.h"
+#include "stimulus.h"
+
+static void StimulusAppend(stimulus* s, size_t* capacity, unsigned int word, unsigned long gapUs) {
+    if (s->count == *capacity) {
+        *capacity = *capacity ? *capacity * 2 : 256;
+        s->words = realloc(s->words, *capacity * sizeof(*s->words));
+        if (!s->words) {
+            perror("stimulus");
+            exit(2);
+        }
+    }
+    s->words[s->count].word = word;
+    s->words[s->count].gapUs = gapUs;
+    s->count++;
+}
+
+int StimulusLoad(stimulus* s, const char* path) {
+    FILE* f = fopen(path, "r");
+    size_t capacity = 0;
+    unsigned long gap = 0;
+    char token[64];
+
+    s->words = NULL;
+    s->count = 0;
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    while (fscanf(f, "%63s", token) == 1) {
+        if (token[0] == '#') {
+            int c;
+            while ((c = fgetc(f)) != EOF && c != '\n');
+        } else if (token[0] == '+') {
+            gap += strtoul(token + 1, NULL, 10);
+        } else {
+            StimulusAppend(s, &capacity, (unsigned int)strtoul(token, NULL, 16) & 0x1FF, gap);
+            gap = 0;
+        }
+    }
+    fclose(f);
+    if (s->count == 0) {
+        fprintf(stderr, "%s: no words\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+// POLL_SLOT for each slot, each answered by a response with a running counter
+void StimulusPollTraffic(stimulus* s, unsigned long frameGapUs) {
+    size_t capacity = 0;
+    unsigned int counter = 0;
+
+    s->words = NULL;
+    s->count = 0;
+    for (unsigned char slot=0; slot < GALAXY_MAX_SLOTS; slot++) {
+        const galaxyCommand* poll = &galaxyCommands[GALAXY_CMD_POLL_SLOT + slot];
+        unsigned int response[6];
+        unsigned short crc = GALAXY_CRC_INITIAL;
+
+        for (unsigned char k=0; k < poll->word_count; k++) {
+            StimulusAppend(s, &capacity, poll->words[k] | (k == 0 ? GALAXY_ADDRESS_FLAG : 0), k == 0 ? frameGapUs : 0);
+        }
+
+        response[0] = 0x10 + slot;
+        response[1] = 6;
+        response[2] = (counter >> 8) & 0xFF;
+        response[3] = counter & 0xFF;
+        for (unsigned char k=0; k < 4; k++) {
+            crc = crc_update(crc, (unsigned char)response[k]);
+        }
+        response[4] = crc >> 8;
+        response[5] = crc & 0xFF;
+        response[0] |= GALAXY_ADDRESS_FLAG;
+        counter++;
+
+        for (unsigned char k=0; k < 6; k++) {
+            StimulusAppend(s, &capacity, response[k], k == 0 ? frameGapUs / 2 : 0);
+        }
+    }
+}
+
+void StimulusFree(stimulus* s) {
+    free(s->words);
+    s->words = NULL;
+    s->count = 0;
+}
@@ -0,0 +1,38 @@
+/* 
+ * File:   stimulus.h
+ *
+ * Bus word streams for the host tools: synthetic poll traffic, or a text
+ * file of hex words. In a file, words carry 0x100 for the address flag and
+ * are separated by white space, "+N" inserts an N microsecond gap before
+ * the next word and '#' comments run to the end of the line.
+ */
+
+#ifndef STIMULUS_H
+#define	STIMULUS_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#include <stddef.h>
+
+typedef struct {
+    unsigned int word;
+    unsigned long gapUs;                    // Idle line before this word
+} stimulusWord;
+
+typedef struct {
+    stimulusWord* words;
+    size_t count;
+} stimulus;
+
+int StimulusLoad(stimulus* s, const char* path);
+void StimulusPollTraffic(stimulus* s, unsigned long frameGapUs);
+void StimulusFree(stimulus* s);
+
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* STIMULUS_H */
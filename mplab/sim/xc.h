@@ -0,0 +1,214 @@
+/* 
+ * File:   xc.h
+ *
+ * Host stand-in for the XC8 device header. Only the PIC18LF26K22 registers
+ * the firmware touches are declared. Plain registers are bytes in sim.c;
+ * registers with hardware side effects (RCREG, TXREG, RCSTA, TXSTA) go
+ * through sim.c so the UART line model sees every access. ei() takes any
+ * pending interrupt straight away, as the core does.
+ */
+
+#ifndef XC_H
+#define	XC_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#define __interrupt(priority)
+#define NOP()
+#define CLRWDT()
+#define SLEEP()                     SimSleep()
+#define di()                        (INTCONbits.GIE = 0)
+#define ei()                        (INTCONbits.GIE = 1, SimDispatchInterrupts())
+
+#define SIM_BIT                     unsigned char
+
+#define SIM_PORT_BITS(p) \
+    typedef union { \
+        struct { SIM_BIT p##0:1; SIM_BIT p##1:1; SIM_BIT p##2:1; SIM_BIT p##3:1; \
+                 SIM_BIT p##4:1; SIM_BIT p##5:1; SIM_BIT p##6:1; SIM_BIT p##7:1; }; \
+    } __##p##bits_t;
+
+SIM_PORT_BITS(LATA)
+SIM_PORT_BITS(LATB)
+SIM_PORT_BITS(LATC)
+SIM_PORT_BITS(TRISA)
+SIM_PORT_BITS(TRISB)
+SIM_PORT_BITS(TRISC)
+SIM_PORT_BITS(RA)
+SIM_PORT_BITS(RB)
+SIM_PORT_BITS(RC)
+
+typedef union {
+    struct { SIM_BIT TX9D:1; SIM_BIT TRMT:1; SIM_BIT BRGH:1; SIM_BIT SENDB:1;
+             SIM_BIT SYNC:1; SIM_BIT TXEN:1; SIM_BIT TX9:1; SIM_BIT CSRC:1; };
+    struct { SIM_BIT :5; SIM_BIT TXEN1:1; };
+    struct { SIM_BIT :5; SIM_BIT TXEN2:1; };
+} __TXSTAbits_t;
+
+typedef union {
+    struct { SIM_BIT RX9D:1; SIM_BIT OERR:1; SIM_BIT FERR:1; SIM_BIT ADDEN:1;
+             SIM_BIT CREN:1; SIM_BIT SREN:1; SIM_BIT RX9:1; SIM_BIT SPEN:1; };
+    struct { SIM_BIT :7; SIM_BIT SPEN1:1; };
+    struct { SIM_BIT :7; SIM_BIT SPEN2:1; };
+} __RCSTAbits_t;
+
+typedef union {
+    struct { SIM_BIT ABDEN:1; SIM_BIT WUE:1; SIM_BIT :1; SIM_BIT BRG16:1;
+             SIM_BIT CKTXP:1; SIM_BIT DTRXP:1; SIM_BIT RCIDL:1; SIM_BIT ABDOVF:1; };
+    struct { SIM_BIT :5; SIM_BIT DTRXP1:1; };
+    struct { SIM_BIT :5; SIM_BIT DTRXP2:1; };
+} __BAUDCONbits_t;
+
+typedef union {
+    struct { SIM_BIT TMR1IF:1; SIM_BIT TMR2IF:1; SIM_BIT CCP1IF:1; SIM_BIT SSP1IF:1;
+             SIM_BIT TX1IF:1; SIM_BIT RC1IF:1; SIM_BIT ADIF:1; SIM_BIT :1; };
+    struct { SIM_BIT TMR1IE:1; SIM_BIT TMR2IE:1; SIM_BIT CCP1IE:1; SIM_BIT SSP1IE:1;
+             SIM_BIT TX1IE:1; SIM_BIT RC1IE:1; SIM_BIT ADIE:1; SIM_BIT :1; };
+    struct { SIM_BIT TMR1IP:1; SIM_BIT TMR2IP:1; SIM_BIT CCP1IP:1; SIM_BIT SSP1IP:1;
+             SIM_BIT TX1IP:1; SIM_BIT RC1IP:1; SIM_BIT ADIP:1; SIM_BIT :1; };
+} __PIR1bits_t;
+
+typedef union {
+    struct { SIM_BIT TMR1GIF:1; SIM_BIT TMR3GIF:1; SIM_BIT TMR5GIF:1; SIM_BIT CTMUIF:1;
+             SIM_BIT TX2IF:1; SIM_BIT RC2IF:1; SIM_BIT BCL2IF:1; SIM_BIT SSP2IF:1; };
+    struct { SIM_BIT TMR1GIE:1; SIM_BIT TMR3GIE:1; SIM_BIT TMR5GIE:1; SIM_BIT CTMUIE:1;
+             SIM_BIT TX2IE:1; SIM_BIT RC2IE:1; SIM_BIT BCL2IE:1; SIM_BIT SSP2IE:1; };
+    struct { SIM_BIT TMR1GIP:1; SIM_BIT TMR3GIP:1; SIM_BIT TMR5GIP:1; SIM_BIT CTMUIP:1;
+             SIM_BIT TX2IP:1; SIM_BIT RC2IP:1; SIM_BIT BCL2IP:1; SIM_BIT SSP2IP:1; };
+} __PIR3bits_t;
+
+typedef union {
+    struct { SIM_BIT TMR4IF:1; SIM_BIT TMR5IF:1; SIM_BIT TMR6IF:1; SIM_BIT :5; };
+    struct { SIM_BIT TMR4IE:1; SIM_BIT TMR5IE:1; SIM_BIT TMR6IE:1; SIM_BIT :5; };
+    struct { SIM_BIT TMR4IP:1; SIM_BIT TMR5IP:1; SIM_BIT TMR6IP:1; SIM_BIT :5; };
+} __PIR5bits_t;
+
+typedef union {
+    struct { SIM_BIT RBIF:1; SIM_BIT INT0IF:1; SIM_BIT TMR0IF:1; SIM_BIT RBIE:1;
+             SIM_BIT INT0IE:1; SIM_BIT TMR0IE:1; SIM_BIT PEIE:1; SIM_BIT GIE:1; };
+    struct { SIM_BIT :2; SIM_BIT T0IF:1; SIM_BIT :2; SIM_BIT T0IE:1; SIM_BIT GIEL:1; SIM_BIT GIEH:1; };
+    struct { SIM_BIT :6; SIM_BIT PEIE_GIEL:1; SIM_BIT GIE_GIEH:1; };
+} __INTCONbits_t;
+
+typedef union {
+    struct { SIM_BIT RBIP:1; SIM_BIT :1; SIM_BIT TMR0IP:1; SIM_BIT :1;
+             SIM_BIT INTEDG2:1; SIM_BIT INTEDG1:1; SIM_BIT INTEDG0:1; SIM_BIT nRBPU:1; };
+} __INTCON2bits_t;
+
+typedef union {
+    struct { SIM_BIT nBOR:1; SIM_BIT nPOR:1; SIM_BIT nPD:1; SIM_BIT nTO:1;
+             SIM_BIT nRI:1; SIM_BIT :1; SIM_BIT SBOREN:1; SIM_BIT IPEN:1; };
+} __RCONbits_t;
+
+typedef union {
+    struct { SIM_BIT T0PS:3; SIM_BIT PSA:1; SIM_BIT T0SE:1; SIM_BIT T0CS:1; SIM_BIT T08BIT:1; SIM_BIT TMR0ON:1; };
+} __T0CONbits_t;
+
+typedef union {
+    struct { SIM_BIT TMR1ON:1; SIM_BIT T1RD16:1; SIM_BIT nT1SYNC:1; SIM_BIT T1SOSCEN:1;
+             SIM_BIT T1CKPS:2; SIM_BIT TMR1CS:2; };
+    struct { SIM_BIT :1; SIM_BIT RD16:1; };
+} __T1CONbits_t;
+
+typedef union {
+    struct { SIM_BIT T2CKPS:2; SIM_BIT TMR2ON:1; SIM_BIT T2OUTPS:4; SIM_BIT :1; };
+} __T2CONbits_t;
+
+typedef union {
+    struct { SIM_BIT T4CKPS:2; SIM_BIT TMR4ON:1; SIM_BIT T4OUTPS:4; SIM_BIT :1; };
+} __T4CONbits_t;
+
+typedef union {
+    struct { SIM_BIT C1TSEL:2; SIM_BIT :1; SIM_BIT C2TSEL:2; SIM_BIT :1; SIM_BIT C3TSEL:2; };
+} __CCPTMRS0bits_t;
+
+typedef union {
+    struct { SIM_BIT SCS:2; SIM_BIT HFIOFS:1; SIM_BIT OSTS:1; SIM_BIT IRCF:3; SIM_BIT IDLEN:1; };
+    struct { SIM_BIT :2; SIM_BIT IOFS:1; };
+} __OSCCONbits_t;
+
+typedef union {
+    struct { SIM_BIT LFIOFS:1; SIM_BIT MFIOFS:1; SIM_BIT PRISD:1; SIM_BIT SOSCGO:1;
+             SIM_BIT MFIOSEL:1; SIM_BIT :1; SIM_BIT SOSCRUN:1; SIM_BIT PLLRDY:1; };
+} __OSCCON2bits_t;
+
+typedef union {
+    struct { SIM_BIT TUN:6; SIM_BIT PLLEN:1; SIM_BIT INTSRC:1; };
+} __OSCTUNEbits_t;
+
+extern volatile unsigned char LATA, LATB, LATC, TRISA, TRISB, TRISC, PORTA, PORTB, PORTC;
+extern volatile unsigned char ANSELA, ANSELB, ANSELC;
+extern volatile unsigned char BAUDCON1, BAUDCON2, SPBRG1, SPBRGH1, SPBRG2, SPBRGH2;
+extern volatile unsigned char PIR1, PIE1, IPR1, PIR3, PIE3, IPR3, PIR5, PIE5, IPR5;
+extern volatile unsigned char INTCON, INTCON2, RCON;
+extern volatile unsigned char T0CON, TMR0H, TMR0L, T1CON, T1GCON, TMR1H, TMR1L;
+extern volatile unsigned char T2CON, TMR2, PR2;
+extern volatile unsigned char T4CON, TMR4, PR4;
+extern volatile unsigned char CCP1CON, CCPR1L, CCPR1H, CCPTMRS0;
+extern volatile unsigned char OSCCON, OSCCON2, OSCTUNE;
+
+#define LATAbits        (*(volatile __LATAbits_t*)&LATA)
+#define LATBbits        (*(volatile __LATBbits_t*)&LATB)
+#define LATCbits        (*(volatile __LATCbits_t*)&LATC)
+#define TRISAbits       (*(volatile __TRISAbits_t*)&TRISA)
+#define TRISBbits       (*(volatile __TRISBbits_t*)&TRISB)
+#define TRISCbits       (*(volatile __TRISCbits_t*)&TRISC)
+#define PORTAbits       (*(volatile __RAbits_t*)&PORTA)
+#define PORTBbits       (*(volatile __RBbits_t*)&PORTB)
+#define PORTCbits       (*(volatile __RCbits_t*)&PORTC)
+#define BAUDCON1bits    (*(volatile __BAUDCONbits_t*)&BAUDCON1)
+#define BAUDCON2bits    (*(volatile __BAUDCONbits_t*)&BAUDCON2)
+#define PIR1bits        (*(volatile __PIR1bits_t*)&PIR1)
+#define PIE1bits        (*(volatile __PIR1bits_t*)&PIE1)
+#define IPR1bits        (*(volatile __PIR1bits_t*)&IPR1)
+#define PIR3bits        (*(volatile __PIR3bits_t*)&PIR3)
+#define PIE3bits        (*(volatile __PIR3bits_t*)&PIE3)
+#define IPR3bits        (*(volatile __PIR3bits_t*)&IPR3)
+#define PIR5bits        (*(volatile __PIR5bits_t*)&PIR5)
+#define PIE5bits        (*(volatile __PIR5bits_t*)&PIE5)
+#define IPR5bits        (*(volatile __PIR5bits_t*)&IPR5)
+#define INTCONbits      (*(volatile __INTCONbits_t*)&INTCON)
+#define INTCON2bits     (*(volatile __INTCON2bits_t*)&INTCON2)
+#define RCONbits        (*(volatile __RCONbits_t*)&RCON)
+#define T0CONbits       (*(volatile __T0CONbits_t*)&T0CON)
+#define T1CONbits       (*(volatile __T1CONbits_t*)&T1CON)
+#define T2CONbits       (*(volatile __T2CONbits_t*)&T2CON)
+#define T4CONbits       (*(volatile __T4CONbits_t*)&T4CON)
+#define CCPTMRS0bits    (*(volatile __CCPTMRS0bits_t*)&CCPTMRS0)
+#define OSCCONbits      (*(volatile __OSCCONbits_t*)&OSCCON)
+#define OSCCON2bits     (*(volatile __OSCCON2bits_t*)&OSCCON2)
+#define OSCTUNEbits     (*(volatile __OSCTUNEbits_t*)&OSCTUNE)
+
+// UART registers with side effects, see sim.c
+volatile __RCSTAbits_t* SimRcsta(unsigned char uart_index);
+volatile __TXSTAbits_t* SimTxsta(unsigned char uart_index);
+unsigned char SimUartRead(unsigned char uart_index);
+volatile unsigned char* SimUartWrite(unsigned char uart_index);
+void SimSleep(void);
+void SimDispatchInterrupts(void);
+
+#define RCSTA1bits      (*SimRcsta(1))
+#define RCSTA2bits      (*SimRcsta(2))
+#define TXSTA1bits      (*SimTxsta(1))
+#define TXSTA2bits      (*SimTxsta(2))
+#define RCSTA1          (*(volatile unsigned char*)SimRcsta(1))
+#define RCSTA2          (*(volatile unsigned char*)SimRcsta(2))
+#define TXSTA1          (*(volatile unsigned char*)SimTxsta(1))
+#define TXSTA2          (*(volatile unsigned char*)SimTxsta(2))
+#define RCREG1          (SimUartRead(1))
+#define RCREG2          (SimUartRead(2))
+#define RC1REG          RCREG1
+#define RC2REG          RCREG2
+#define TXREG1          (*SimUartWrite(1))
+#define TXREG2          (*SimUartWrite(2))
+#define TX1REG          TXREG1
+#define TX2REG          TXREG2
+
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* XC_H */
@@ -0,0 +1,236 @@
+#include <xc.h>
+#include "app.h"
+#include "fifo.h"
+#include "uart.h"
+#include "galaxy.h"
+#include "tick.h"
+#include "host.h"
+#include "capture.h"
+#include "filter.h"
+#include "stats.h"
+#include "scheduler.h"
+
+// Dump states
+#define STATS_DUMP_IDLE             0
+#define STATS_DUMP_COUNTERS         1
+#define STATS_DUMP_ADDRESSES        2
+
+statsCounters stats;
+
+static unsigned char statsAddressFrames[256];   // Good frames per address low byte, since the last dump
+static unsigned char statsDumpState = STATS_DUMP_IDLE;
+static unsigned int statsDumpAddress = 0;       // Next address to report
+static unsigned int statsPeriodTicks = 0;       // 0: only on request
+static unsigned int statsLastDumpTick = 0;
+
+void StatsInitialize(void) {
+    stats.words = 0;
+    stats.frames = 0;
+    stats.crcErrors = 0;
+    stats.lengthErrors = 0;
+    stats.faults = 0;
+    stats.framingErrors = 0;
+    stats.overruns = 0;
+    stats.decoderDropped = 0;
+    for (unsigned int x=0; x < 256; x++) {
+        statsAddressFrames[x] = 0;
+    }
+    statsDumpState = STATS_DUMP_IDLE;
+    statsPeriodTicks = 0;
+}
+
+//===============================================================================
+//	Description:	Counts one received word and what the decoder made of it.
+//					Runs for every word, so the common case is one increment
+//					and two tests.
+//
+//	Params:			WORD			UINT		Received word, fault bits included
+//					RESULT			UCHAR		GalaxyDecode result for the word
+//
+//	Returns:			NONE
+//===============================================================================
+void StatsWord(unsigned int word, unsigned char result) {
+    stats.words++;
+    if (word & GALAXY_FAULT_MASK) {
+        if (word & UART_FAULT_FRAMING_ERROR) {
+            stats.framingErrors++;
+        }
+        if (word & UART_FAULT_OVERRUN_ERROR) {
+            stats.overruns++;
+        }
+    }
+    switch (result) {
+        case GALAXY_DECODE_NONE:
+            break;
+        case GALAXY_DECODE_FRAME:
+            stats.frames++;
+            break;
+        case GALAXY_DECODE_CRC_ERROR:
+            stats.crcErrors++;
+            break;
+        case GALAXY_DECODE_LENGTH_ERROR:
+            stats.lengthErrors++;
+            break;
+        case GALAXY_DECODE_FAULT:
+            stats.faults++;
+            break;
+        case GALAXY_DECODE_DROPPED:
+            stats.decoderDropped++;
+            break;
+    }
+}
+
+// Call for each frame the decoder hands out
+void StatsFrame(galaxyBuffer* frame) {
+    unsigned char* count = &statsAddressFrames[frame->buffer[0]];
+
+    if (*count != STATS_ADDRESS_SATURATED) {
+        (*count)++;
+    }
+}
+
+// Starts a dump unless one is already on its way out
+void StatsDump(void) {
+    if (statsDumpState == STATS_DUMP_IDLE) {
+        statsDumpState = STATS_DUMP_COUNTERS;
+    }
+}
+
+static unsigned char* StatsPut16(unsigned char* p, unsigned int value) {
+    p[0] = (unsigned char)value;
+    p[1] = (unsigned char)(value >> 8);
+    return p + 2;
+}
+
+static unsigned char* StatsPut32(unsigned char* p, unsigned long value) {
+    p = StatsPut16(p, (unsigned int)value);
+    return StatsPut16(p, (unsigned int)(value >> 16));
+}
+
+static unsigned char StatsSendCounters(void) {
+    unsigned char payload[STATS_PAYLOAD_SIZE];
+    unsigned char* p = payload;
+    unsigned char interrupts = INTCONbits.GIEH;
+    unsigned int overrunsAvoided;
+    unsigned long elapsed;
+    unsigned long idle;
+    fifoStats fifo;
+
+    // Written by the receive ISR, and 16 bit reads are not atomic
+    INTCONbits.GIEH = 0;
+    overrunsAvoided = rxOverrunsAvoided;
+    INTCONbits.GIEH = interrupts;
+
+    p = StatsPut16(p, TickNow());
+    p = StatsPut32(p, stats.words);
+    p = StatsPut32(p, stats.frames);
+    p = StatsPut16(p, stats.crcErrors);
+    p = StatsPut16(p, stats.lengthErrors);
+    p = StatsPut16(p, stats.faults);
+    p = StatsPut16(p, stats.framingErrors);
+    p = StatsPut16(p, stats.overruns);
+    p = StatsPut16(p, stats.decoderDropped);
+    p = StatsPut16(p, overrunsAvoided);
+    p = StatsPut16(p, captureDroppedPackets);
+    p = StatsPut32(p, filterDropped);
+    // Checked first, reset snapshots must not be thrown away
+    if (!HostCanSend(STATS_PAYLOAD_SIZE)) {
+        return FALSE;
+    }
+    for (unsigned char x=0; x < FIFO_COUNT; x++) {
+        FifoStatsSnapshot(&buffers[x], &fifo, TRUE);
+        *p++ = fifo.peak;
+        p = StatsPut16(p, fifo.failures);
+        p = StatsPut32(p, fifo.total);
+    }
+    SchedLoadSnapshot(&elapsed, &idle, TRUE);
+    p = StatsPut32(p, elapsed);
+    p = StatsPut32(p, idle);
+    return HostSendPacket(HOST_PACKET_STATS, payload, STATS_PAYLOAD_SIZE);
+}
+
+// Sends the next packet of address records and clears the counts it
+// carried, TRUE once the last one is out
+static unsigned char StatsSendAddresses(void) {
+    unsigned char payload[1 + STATS_ADDRESSES_PER_PACKET * STATS_ADDRESS_RECORD_SIZE];
+    unsigned char length = 1;
+    unsigned char records = 0;
+    unsigned int address = statsDumpAddress;
+
+    while (address < 256 && records < STATS_ADDRESSES_PER_PACKET) {
+        if (statsAddressFrames[address] != 0) {
+            payload[length] = (unsigned char)address;
+            payload[length + 1] = statsAddressFrames[address];
+            length += STATS_ADDRESS_RECORD_SIZE;
+            records++;
+        }
+        address++;
+    }
+    // Skip the trailing empty addresses so the last flag rides on this packet
+    while (address < 256 && statsAddressFrames[address] == 0) {
+        address++;
+    }
+    payload[0] = (address == 256) ? STATS_ADDRESSES_LAST : 0;
+
+    if (!HostSendPacket(HOST_PACKET_STATS_ADDRESSES, payload, length)) {
+        return FALSE;
+    }
+    while (statsDumpAddress < address) {
+        statsAddressFrames[statsDumpAddress++] = 0;
+    }
+    return address == 256;
+}
+
+//===============================================================================
+//	Description:	Moves a pending dump along one packet per call, retrying
+//					while HOST_TX_FIFO is full. Call from the main loop.
+//
+//	Params:			NONE
+//
+//	Returns:			NONE
+//===============================================================================
+void StatsService(void) {
+    if (statsPeriodTicks != 0 && (unsigned int)(TickNow() - statsLastDumpTick) >= statsPeriodTicks) {
+        StatsDump();
+    }
+
+    switch (statsDumpState) {
+        case STATS_DUMP_COUNTERS:
+            if (StatsSendCounters()) {
+                statsLastDumpTick = TickNow();
+                statsDumpAddress = 0;
+                statsDumpState = STATS_DUMP_ADDRESSES;
+            }
+            break;
+        case STATS_DUMP_ADDRESSES:
+            if (StatsSendAddresses()) {
+                statsDumpState = STATS_DUMP_IDLE;
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+//===============================================================================
+//	Description:	HOST_COMMAND_STATS handler. An empty payload asks for one
+//					dump, two bytes (LE) set the periodic dump interval in
+//					ticks, 0 to stop.
+//
+//	Params:			PAYLOAD			UCHAR*		Command payload
+//					LENGTH			UCHAR		Payload length
+//
+//	Returns:			HOST_STATUS_OK or STATS_ERROR_LENGTH
+//===============================================================================
+unsigned char StatsHostCommand(const unsigned char* payload, unsigned char length) {
+    if (length == 0) {
+        StatsDump();
+        return HOST_STATUS_OK;
+    }
+    if (length != 2) {
+        return STATS_ERROR_LENGTH;
+    }
+    statsPeriodTicks = payload[0] | ((unsigned int)payload[1] << 8);
+    statsLastDumpTick = TickNow();
+    return HOST_STATUS_OK;
+}
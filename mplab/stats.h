@@ -0,0 +1,80 @@
+/*
+ * File:   stats.h
+ *
+ * Bus health counters, updated from the receive path and sent to the host
+ * on request or every few ticks. A dump is one HOST_PACKET_STATS
+ * followed by HOST_PACKET_STATS_ADDRESSES packets until one has the last
+ * flag set. HOST_PACKET_STATS payload, multi-byte fields LE:
+ *
+ *     tick                2 bytes, TickNow() when the dump started
+ *     words               4 bytes, words received on UART1
+ *     frames              4 bytes, frames with a good CRC
+ *     CRC errors          2 bytes
+ *     length errors       2 bytes, bad length field or frame cut short
+ *     faults              2 bytes, UART fault inside a frame
+ *     framing errors      2 bytes, words with UART_FAULT_FRAMING_ERROR
+ *     overruns            2 bytes, words with UART_FAULT_OVERRUN_ERROR
+ *     decoder dropped     2 bytes, frames lost to a full decoder queue
+ *     overruns avoided    2 bytes, second word already waiting in the ISR
+ *     capture dropped     2 bytes, capture packets lost to a full HOST_TX_FIFO
+ *     filter dropped      4 bytes, words the capture filter rejected
+ *     FIFOs               FIFO_COUNT records of
+ *                             peak            1 byte, most words held
+ *                             failures        2 bytes, enqueues refused
+ *                             total           4 bytes, words enqueued
+ *     elapsed             4 bytes, timestamp units since the previous dump
+ *     idle                4 bytes, of those spent in IDLE (scheduler.h)
+ *
+ * The FIFO records, load and address counts cover the time since the
+ * previous dump, everything else counts from power up. Words lost to a full DEVICE_RX_FIFO are its
+ * failures.
+ *
+ * HOST_PACKET_STATS_ADDRESSES payload is a flags byte then up to
+ * STATS_ADDRESSES_PER_PACKET records of address low byte and a 1 byte
+ * frame count since the previous dump, STATS_ADDRESS_SATURATED for that
+ * many or more. Only addresses with frames are sent.
+ */
+
+#ifndef STATS_H
+#define	STATS_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#define STATS_FIFO_RECORD_SIZE      7
+#define STATS_PAYLOAD_SIZE          (30 + FIFO_COUNT * STATS_FIFO_RECORD_SIZE + 8)
+#define STATS_ADDRESSES_PER_PACKET  16
+#define STATS_ADDRESS_RECORD_SIZE   2
+#define STATS_ADDRESS_SATURATED     0xFF
+#define STATS_ADDRESSES_LAST        0x01    // Flags: final packet of the dump
+
+// Host command status codes
+#define STATS_ERROR_LENGTH          1
+
+typedef struct {
+    unsigned long words;
+    unsigned long frames;
+    unsigned int crcErrors;
+    unsigned int lengthErrors;
+    unsigned int faults;
+    unsigned int framingErrors;
+    unsigned int overruns;
+    unsigned int decoderDropped;
+} statsCounters;
+
+extern statsCounters stats;
+
+void StatsInitialize(void);
+void StatsWord(unsigned int word, unsigned char result);
+void StatsFrame(galaxyBuffer* frame);
+void StatsDump(void);
+void StatsService(void);
+unsigned char StatsHostCommand(const unsigned char* payload, unsigned char length);
+
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* STATS_H */
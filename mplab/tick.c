@@ -0,0 +1,32 @@
+#include <xc.h>
+#include "app.h"
+#include "tick.h"
+
+static volatile unsigned int tickCount = 0;
+
+void TickInitialize(void) {
+    T2CON = ((TICK_TIMER2_POSTSCALE - 1) << 3) | TICK_TIMER2_CKPS;    // Off
+    TMR2 = 0;
+    PR2 = TICK_TIMER2_PERIOD - 1;           // Counts 0..PR2
+    IPR1bits.TMR2IP = 0;                    // Use low priority ISR
+    PIR1bits.TMR2IF = 0;
+    PIE1bits.TMR2IE = 1;                    // Enable interrupt on the postscaled match
+    T2CONbits.TMR2ON = 1;                   // Enable the timer
+}
+
+// Called from LowIsr on TMR2IF. Timer2 has already started the next
+// period, so nothing is reloaded.
+void TickInterrupt(void) {
+    PIR1bits.TMR2IF = 0;                    // Clear the interrupt flag
+    tickCount++;
+}
+
+// Free running tick count. Compare with unsigned subtraction to handle wrap.
+unsigned int TickNow(void) {
+    unsigned int now;
+    // The ISR may update tickCount between the two byte reads
+    do {
+        now = tickCount;
+    } while (now != tickCount);
+    return now;
+}
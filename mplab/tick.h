@@ -0,0 +1,45 @@
+/* 
+ * File:   tick.h
+ *
+ * Periodic system tick from Timer2, serviced by the low priority ISR.
+ * Timer2 clears itself on the PR2 match, so the period is exact whatever
+ * the ISR latency and nothing is reloaded in software.
+ */
+
+#ifndef TICK_H
+#define	TICK_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#define TICK_RATE_HZ                500
+
+// Timer2 counts FOSC/4 through a 1:16 prescaler from 0 to PR2, and every
+// TICK_TIMER2_POSTSCALE matches raise TMR2IF. The smallest postscaler
+// that fits the 8 bit period is used.
+#define TICK_CYCLES                 (_XTAL_FREQ / 4 / TICK_RATE_HZ)
+#define TICK_TIMER2_PRESCALE        16
+#define TICK_TIMER2_CKPS            0x02    // T2CKPS for 1:16
+#define TICK_TIMER2_POSTSCALE       ((TICK_CYCLES + TICK_TIMER2_PRESCALE * 256UL - 1) / (TICK_TIMER2_PRESCALE * 256UL))
+#define TICK_TIMER2_PERIOD          (TICK_CYCLES / (TICK_TIMER2_PRESCALE * TICK_TIMER2_POSTSCALE))
+#define TICK_TIMER2_CYCLES          (TICK_TIMER2_PERIOD * TICK_TIMER2_PRESCALE * TICK_TIMER2_POSTSCALE)
+#define TICK_PERIOD_US              ((TICK_TIMER2_CYCLES * 4 * 1000) / (_XTAL_FREQ / 1000))
+
+#if TICK_TIMER2_POSTSCALE > 16 || TICK_TIMER2_PERIOD < 2
+#error "TICK_RATE_HZ is out of Timer2 range"
+#endif
+#if TICK_TIMER2_CYCLES != TICK_CYCLES
+#warning "TICK_RATE_HZ is not a whole number of Timer2 counts, the tick runs fast"
+#endif
+
+void TickInitialize(void);
+void TickInterrupt(void);
+unsigned int TickNow(void);
+
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* TICK_H */
@@ -0,0 +1,56 @@
+#include <xc.h>
+#include "app.h"
+#include "timestamp.h"
+
+static volatile unsigned int timestampOverflows = 0;
+
+void TimestampInitialize(void) {
+    T1CONbits.TMR1ON = 0;                   // Off
+    T1CON = 0x36;                           // FOSC/4, 1:8 prescaler, 16 bit reads
+    T1GCON = 0;                             // Not gated
+    TMR1H = 0;
+    TMR1L = 0;
+    IPR1bits.TMR1IP = 1;                    // Use high priority ISR
+    PIR1bits.TMR1IF = 0;
+    PIE1bits.TMR1IE = 1;                    // Enable interrupt on TMR1 overflow
+    INTCONbits.PEIE = 1;
+    T1CONbits.TMR1ON = 1;                   // Enable the timer
+}
+
+// Called from HighIsr on TMR1IF
+void TimestampInterrupt(void) {
+    PIR1bits.TMR1IF = 0;
+    timestampOverflows++;
+}
+
+// Safe from both main() and the ISRs. Compare with unsigned subtraction.
+// HighIsr reads the clock too, and a read between TMR1L and TMR1H would
+// reload the RD16 latch, so the pair is read with GIEH clear.
+unsigned long TimestampNow(void) {
+    unsigned char interrupts = INTCONbits.GIEH;
+    unsigned int high;
+    unsigned char low;
+    unsigned char mid;
+    unsigned char pending;
+
+    INTCONbits.GIEH = 0;
+    high = timestampOverflows;
+    low = TMR1L;                            // Latches TMR1H
+    mid = TMR1H;
+    pending = PIR1bits.TMR1IF;
+    INTCONbits.GIEH = interrupts;
+
+    // Overflow not yet counted, inside an ISR or masked above
+    if (pending && mid < 0x80) {
+        high++;
+    }
+    return ((unsigned long)high << 16) | ((unsigned int)mid << 8) | low;
+}
+
+// Rebuilds a full timestamp from its low 16 bits, taken less than one
+// Timer1 lap (32 ms) ago
+unsigned long TimestampExtend(unsigned int low) {
+    unsigned long now = TimestampNow();
+
+    return now - (unsigned int)((unsigned int)now - low);
+}
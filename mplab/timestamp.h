@@ -0,0 +1,28 @@
+/* 
+ * File:   timestamp.h
+ *
+ * Free running 32 bit timestamp: Timer1 counts FOSC/4 / 8 and the high
+ * priority ISR extends it by counting overflows.
+ */
+
+#ifndef TIMESTAMP_H
+#define	TIMESTAMP_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#define TIMESTAMP_PRESCALE          8
+#define TIMESTAMP_TICKS_PER_US      (_XTAL_FREQ / 4 / TIMESTAMP_PRESCALE / 1000000)
+
+void TimestampInitialize(void);
+void TimestampInterrupt(void);
+unsigned long TimestampNow(void);
+unsigned long TimestampExtend(unsigned int low);
+
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* TIMESTAMP_H */
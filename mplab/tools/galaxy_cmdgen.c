@@ -0,0 +1,110 @@
+/*
+ * File:   galaxy_cmdgen.c
+ *
+ * Host tool that expands galaxy_commands.def into the const command table
+ * with precomputed CRCs. Built and run by 'make commands':
+ *
+ *     cc -I. -o tools/galaxy_cmdgen tools/galaxy_cmdgen.c galaxy.c
+ *     tools/galaxy_cmdgen > galaxy_commands.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "app.h"
+#include "galaxy.h"
+
+#define UNPAREN(...) __VA_ARGS__
+
+typedef struct {
+    const char* name;
+    unsigned char opcode;
+    unsigned char per_slot;
+    const unsigned char* payload;
+    unsigned char payload_count;
+} commandSpec;
+
+static const commandSpec specs[] = {
+#define GALAXY_COMMAND(name, opcode, payload) \
+    { #name, opcode, 0, (const unsigned char[]){ UNPAREN payload }, \
+      sizeof((const unsigned char[]){ UNPAREN payload }) },
+#define GALAXY_SLOT_COMMAND(name, opcode) \
+    { #name, opcode, 1, 0, 1 },
+#include "galaxy_commands.def"
+#undef GALAXY_COMMAND
+#undef GALAXY_SLOT_COMMAND
+};
+
+static unsigned int count = 0;
+
+static void emit(const commandSpec* spec, const unsigned char* payload, int slot) {
+    unsigned char words[GALAXY_COMMAND_MAX_WORDS];
+    unsigned char word_count = 0;
+    unsigned short crc = GALAXY_CRC_INITIAL;
+
+    if (spec->payload_count > GALAXY_COMMAND_MAX_PAYLOAD) {
+        fprintf(stderr, "%s: payload longer than GALAXY_COMMAND_MAX_PAYLOAD\n", spec->name);
+        exit(1);
+    }
+
+    words[word_count++] = GALAXY_BROADCAST_ADDRESS & 0xFF;
+    words[word_count++] = spec->payload_count + 5;
+    words[word_count++] = spec->opcode;
+    for (unsigned char i = 0; i < spec->payload_count; i++) {
+        words[word_count++] = payload[i];
+    }
+    for (unsigned char i = 0; i < word_count; i++) {
+        crc = crc_update(crc, words[i]);
+    }
+    words[word_count++] = crc >> 8;
+    words[word_count++] = crc & 0xFF;
+
+    if (slot < 0) {
+        printf("    // %s\n", spec->name);
+    } else {
+        printf("    // %s %d\n", spec->name, slot);
+    }
+    printf("    { %u, {", word_count);
+    for (unsigned char i = 0; i < word_count; i++) {
+        printf(" 0x%02X%s", words[i], i + 1 < word_count ? "," : "");
+    }
+    printf(" } },\n");
+    count++;
+}
+
+int main(void) {
+    printf("/*\n"
+           " * File:   galaxy_commands.c\n"
+           " *\n"
+           " * Generated from galaxy_commands.def by tools/galaxy_cmdgen - do not edit!\n"
+           " * Regenerate with 'make commands'.\n"
+           " */\n"
+           "\n"
+           "#include \"app.h\"\n"
+           "#include \"galaxy.h\"\n"
+           "\n"
+           "const galaxyCommand galaxyCommands[] = {\n");
+
+    for (unsigned int i = 0; i < sizeof(specs) / sizeof(specs[0]); i++) {
+        if (specs[i].per_slot) {
+            for (int slot = 0; slot < GALAXY_MAX_SLOTS; slot++) {
+                unsigned char payload = (unsigned char)slot;
+                emit(&specs[i], &payload, slot);
+            }
+        } else {
+            emit(&specs[i], specs[i].payload, -1);
+        }
+    }
+
+    printf("};\n"
+           "\n"
+           "// Fails to compile when this table is stale, run 'make commands'\n"
+           "typedef char galaxyCommandsComplete[sizeof(galaxyCommands) / sizeof(galaxyCommands[0])\n"
+           "                                    == GALAXY_COMMAND_COUNT ? 1 : -1];\n");
+
+    if (count != GALAXY_COMMAND_COUNT) {
+        fprintf(stderr, "generated %u commands, GALAXY_COMMAND_COUNT is %u\n",
+                count, (unsigned int)GALAXY_COMMAND_COUNT);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,168 @@
+#include "app.h"
+#include "galaxy.h"
+#include "trigger.h"
+
+static triggerPattern triggerPatterns[TRIGGER_MAX_PATTERNS];
+
+// Bit p of triggerLowNibble[n] is set when low nibble n matches state
+// position p, likewise triggerHighNibble[] for bits 4-7 and triggerNinth[]
+// for bit 8. A mask compares bit by bit, so the nibbles match apart.
+static unsigned int triggerLowNibble[16];
+static unsigned int triggerHighNibble[16];
+static unsigned int triggerNinth[2];
+static unsigned int triggerStart;           // First word of every pattern
+static unsigned int triggerPinMask[TRIGGER_PIN_COUNT];   // Last words, per pin
+static unsigned int triggerState;
+
+// Rebuilds the match tables from triggerPatterns
+static void TriggerCompile(void) {
+    unsigned int bit = 1;
+
+    for (unsigned char n=0; n < 16; n++) {
+        triggerLowNibble[n] = 0;
+        triggerHighNibble[n] = 0;
+    }
+    triggerNinth[0] = 0;
+    triggerNinth[1] = 0;
+    triggerStart = 0;
+    for (unsigned char x=0; x < TRIGGER_PIN_COUNT; x++) {
+        triggerPinMask[x] = 0;
+    }
+
+    for (unsigned char k=0; k < TRIGGER_MAX_PATTERNS; k++) {
+        triggerPattern* pattern = &triggerPatterns[k];
+        if (pattern->length == 0) {
+            continue;
+        }
+        triggerStart |= bit;
+        for (unsigned char p=0; p < pattern->length; p++) {
+            unsigned int value = pattern->words[p].value;
+            unsigned int mask = pattern->words[p].mask;
+
+            for (unsigned char n=0; n < 16; n++) {
+                if (((n ^ value) & mask & 0x0F) == 0) {
+                    triggerLowNibble[n] |= bit;
+                }
+                if (((n ^ (value >> 4)) & (mask >> 4) & 0x0F) == 0) {
+                    triggerHighNibble[n] |= bit;
+                }
+            }
+            if (!(mask & 0x100) || !(value & 0x100)) {
+                triggerNinth[0] |= bit;
+            }
+            if (!(mask & 0x100) || (value & 0x100)) {
+                triggerNinth[1] |= bit;
+            }
+            bit = bit << 1;
+        }
+        triggerPinMask[pattern->pin - TRIGGER_PIN_FIRST] |= bit >> 1;
+    }
+    triggerState = 0;
+}
+
+// Loads the original hard-coded trigger: 0x100, 0x017, 0x072 on DIG_OUT_12
+void TriggerInitialize(void) {
+    const triggerWord command[3] = {
+        { 0x100, TRIGGER_MASK_ALL },
+        { 0x017, TRIGGER_MASK_ALL },
+        { 0x072, TRIGGER_MASK_ALL },
+    };
+
+    for (unsigned char k=0; k < TRIGGER_MAX_PATTERNS; k++) {
+        triggerPatterns[k].length = 0;
+    }
+    TriggerSet(0, TRIGGER_PIN_FIRST, command, 3);
+}
+
+unsigned char TriggerSet(unsigned char index, unsigned char pin, const triggerWord* words, unsigned char length) {
+    unsigned char used = 0;
+
+    if (index >= TRIGGER_MAX_PATTERNS) {
+        return TRIGGER_ERROR_INDEX;
+    }
+    if (pin < TRIGGER_PIN_FIRST || pin >= TRIGGER_PIN_FIRST + TRIGGER_PIN_COUNT) {
+        return TRIGGER_ERROR_PIN;
+    }
+    if (length == 0 || length > TRIGGER_MAX_LENGTH) {
+        return TRIGGER_ERROR_LENGTH;
+    }
+    for (unsigned char k=0; k < TRIGGER_MAX_PATTERNS; k++) {
+        if (k != index) {
+            used += triggerPatterns[k].length;
+        }
+    }
+    if (used + length > TRIGGER_MAX_POSITIONS) {
+        return TRIGGER_ERROR_FULL;
+    }
+
+    triggerPatterns[index].pin = pin;
+    triggerPatterns[index].length = length;
+    for (unsigned char p=0; p < length; p++) {
+        triggerPatterns[index].words[p] = words[p];
+    }
+    TriggerCompile();
+    return TRIGGER_OK;
+}
+
+void TriggerClear(unsigned char index) {
+    if (index < TRIGGER_MAX_PATTERNS) {
+        triggerPatterns[index].length = 0;
+        TriggerCompile();
+    }
+}
+
+//===============================================================================
+//	Description:	Advances every pattern by one received word.
+//
+//	Params:			WORD			UINT		Received word, fault bits included
+//
+//	Returns:			Trigger pins to drive high, bit 0 for DIG_OUT_12
+//===============================================================================
+unsigned char TriggerUpdate(unsigned int word) {
+    unsigned char pins = 0;
+
+    // A damaged word breaks every partial match
+    if (word & GALAXY_FAULT_MASK) {
+        triggerState = 0;
+        return 0;
+    }
+    triggerState = ((triggerState << 1) | triggerStart) & triggerLowNibble[word & 0x0F] &
+            triggerHighNibble[(word >> 4) & 0x0F] & triggerNinth[(word >> 8) & 1];
+
+    for (unsigned char x=0; x < TRIGGER_PIN_COUNT; x++) {
+        if (triggerState & triggerPinMask[x]) {
+            pins |= (1 << x);
+        }
+    }
+    return pins;
+}
+
+// Host payload: index, pin, length, then per word value and mask as
+// little-endian 16-bit values
+unsigned char TriggerHostSet(const unsigned char* payload, unsigned char length) {
+    triggerWord words[TRIGGER_MAX_LENGTH];
+    unsigned char count;
+
+    if (length < 3) {
+        return TRIGGER_ERROR_LENGTH;
+    }
+    count = payload[2];
+    if (count > TRIGGER_MAX_LENGTH || length != 3 + 4 * count) {
+        return TRIGGER_ERROR_LENGTH;
+    }
+    for (unsigned char p=0; p < count; p++) {
+        const unsigned char* w = &payload[3 + 4 * p];
+        words[p].value = w[0] | ((unsigned int)w[1] << 8);
+        words[p].mask = w[2] | ((unsigned int)w[3] << 8);
+    }
+    return TriggerSet(payload[0], payload[1], words, count);
+}
+
+// Host payload: index
+unsigned char TriggerHostClear(const unsigned char* payload, unsigned char length) {
+    if (length != 1 || payload[0] >= TRIGGER_MAX_PATTERNS) {
+        return TRIGGER_ERROR_INDEX;
+    }
+    TriggerClear(payload[0]);
+    return TRIGGER_OK;
+}
@@ -0,0 +1,59 @@
+/* 
+ * File:   trigger.h
+ *
+ * Multi-pattern trigger engine for the DIG_OUT_12..14 scope outputs. All
+ * patterns run as one shift-and automaton: each pattern word is a bit in a
+ * 16-bit state vector, so a received word costs three table lookups and
+ * a shift however many patterns are loaded. Pattern words carry a mask of
+ * the bits to compare, a zero mask is a wildcard.
+ */
+
+#ifndef TRIGGER_H
+#define	TRIGGER_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+
+#define TRIGGER_MAX_PATTERNS        4
+#define TRIGGER_MAX_LENGTH          8       // Words per pattern
+#define TRIGGER_MAX_POSITIONS       16      // Words across all patterns, bits in the state
+#define TRIGGER_PIN_FIRST           12      // DIG_OUT_12
+#if PROFILE_ENABLED && PROFILE_PIN
+#define TRIGGER_PIN_COUNT           2       // DIG_OUT_12..13, 14 is the profile pin
+#else
+#define TRIGGER_PIN_COUNT           3       // DIG_OUT_12..14
+#endif
+#define TRIGGER_MASK_ALL            0x01FF
+
+// Status codes
+#define TRIGGER_OK                  0
+#define TRIGGER_ERROR_INDEX         1
+#define TRIGGER_ERROR_PIN           2
+#define TRIGGER_ERROR_LENGTH        3
+#define TRIGGER_ERROR_FULL          4       // Out of state bits
+
+typedef struct {
+    unsigned int value;
+    unsigned int mask;                      // Bits of value that must match
+} triggerWord;
+
+typedef struct {
+    unsigned char length;                   // 0 when unused
+    unsigned char pin;                      // DIG_OUT number
+    triggerWord words[TRIGGER_MAX_LENGTH];
+} triggerPattern;
+
+void TriggerInitialize(void);
+unsigned char TriggerSet(unsigned char index, unsigned char pin, const triggerWord* words, unsigned char length);
+void TriggerClear(unsigned char index);
+unsigned char TriggerUpdate(unsigned int word);
+unsigned char TriggerHostSet(const unsigned char* payload, unsigned char length);
+unsigned char TriggerHostClear(const unsigned char* payload, unsigned char length);
+
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* TRIGGER_H */
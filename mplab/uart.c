@@ -1,23 +1,43 @@
 #include <xc.h>
 #include "app.h"
+#include "fifo.h"
 #include "uart.h"
 
+// Register values written whole by UART_Initialize
+#define UART_TXSTA_BRGH                 0x04
+#define UART_TXSTA_TX9                  0x40
+#define UART_RCSTA_CREN                 0x10
+#define UART_RCSTA_RX9                  0x40
+#define UART_RCSTA_SPEN                 0x80
+#define UART_BAUDCON_BRG16              0x08
+#define UART_BAUDCON_DTRXP              0x20
+
+const unsigned int uartSpbrg[UART_BAUD_CODE_COUNT] = {
+    UART_SPBRG(UART_BAUD_4800),
+    UART_SPBRG(UART_BAUD_9600),
+    UART_SPBRG(UART_BAUD_19200),
+    UART_SPBRG(UART_BAUD_38400),
+    UART_SPBRG(UART_BAUD_57600),
+    UART_SPBRG(UART_BAUD_115200),
+    UART_SPBRG(UART_BAUD_460800),
+};
+
 //===============================================================================
 //	Description:	This function initializes the internal UART.
 //
-//	Params:			BAUD				ULONG		Desired baud rate
+//	Params:			BAUD_CODE			UCHAR		UART_BAUD_CODE_ rate
 //						MODE_9BIT		UCHAR		Cofnigure 8 or 9 bit mode
 //						INTERRUPT_C...	UCHAR		Configure interrupt control
 //
 //	Returns:			NONE
 //===============================================================================
 void UART_Initialize (	unsigned char uart_index,
-                        unsigned long baud, 
+                        unsigned char baud_code,
                         unsigned char mode_9bit, 
                         unsigned char interrupt_control )
 {
-	unsigned long temp = 0;
-	unsigned long clock_freq = _XTAL_FREQ;
+	unsigned char txsta = UART_TXSTA_BRGH;
+	unsigned char rcsta = UART_RCSTA_SPEN | UART_RCSTA_CREN;
 
 	/*
 	RECEPTION
@@ -51,85 +71,58 @@ void UART_Initialize (	unsigned char uart_index,
 			are set.
 	*/
 
-	// Set BRG Control
-    if (uart_index == UART1_INDEX) {
-        BAUDCON1bits.BRG16 = 1;
-        TXSTA1bits.BRGH = 1;
-    } else if (uart_index == UART2_INDEX) {
-        BAUDCON2bits.BRG16 = 1;
-        TXSTA2bits.BRGH = 1;
-    }
+	// 9 bit reception & transmission (Enabled => 1)
+	if (mode_9bit == UART_9BIT_MODE)
+	{
+		txsta |= UART_TXSTA_TX9;
+		rcsta |= UART_RCSTA_RX9;
+	}
 
-	// Calculate value for baud register, given the states of BRG16 and BRGH
-	temp = clock_freq / baud;
-    temp = (temp / 4);
-	temp = temp - 1;
-    if (uart_index == UART1_INDEX) {
-        SPBRGH1 = temp >> 8;
-        SPBRG1 = (char)temp;
-    } else if (uart_index == UART2_INDEX) {
-        SPBRGH2 = temp >> 8;
-        SPBRG2 = (char)temp;
-    }
-    
 	// RX & TX must be configured as inputs for UART to work
     if (uart_index == UART1_INDEX) {
         TRISCbits.TRISC6 = 1;
         TRISCbits.TRISC7 = 1;
-        TXSTA1bits.SYNC = 0;
     } else if (uart_index == UART2_INDEX) {
         TRISBbits.TRISB6 = 1;
         TRISBbits.TRISB7 = 1;
-        TXSTA2bits.SYNC = 0;
     }
-    
-	// 9 bit reception & transmission (Enabled => 1)
-	if (mode_9bit == UART_9BIT_MODE)
-	{
-        if (uart_index == UART1_INDEX) {
-            RCSTA1bits.RX9 = 1;
-            TXSTA1bits.TX9 = 1;
-        } else if (uart_index == UART2_INDEX) {
-            RCSTA2bits.RX9 = 1;
-            TXSTA2bits.TX9 = 1;
-        }
-	}
-	else
-	{
-        if (uart_index == UART1_INDEX) {
-            RCSTA1bits.RX9 = 0;
-            TXSTA1bits.TX9 = 0;
-        } else if (uart_index == UART2_INDEX) {
-            RCSTA2bits.RX9 = 0;
-            TXSTA2bits.TX9 = 0;
-        }
-	}
 
-    BAUDCON1bits.DTRXP1 = 1;
-    
-	// Enable Receiver Hardware Circuitry
+	// Whole registers, serial port held in reset until the rate is set.
+	// SYNC = 0 for asynchronous mode, TXEN is set last.
     if (uart_index == UART1_INDEX) {
-        RCSTA1bits.CREN = 1;
+        RCSTA1 = 0;
+        BAUDCON1 = UART_BAUDCON_BRG16 | UART_BAUDCON_DTRXP;
+        TXSTA1 = txsta;
     } else if (uart_index == UART2_INDEX) {
-        RCSTA2bits.CREN = 1;
+        RCSTA2 = 0;
+        BAUDCON2 = UART_BAUDCON_BRG16;
+        TXSTA2 = txsta;
     }
-
-    // Enable Serial Port
+    UART_SetBaud(uart_index, baud_code);
     if (uart_index == UART1_INDEX) {
-        RCSTA1bits.SPEN = 1;
+        RCSTA1 = rcsta;
     } else if (uart_index == UART2_INDEX) {
-        RCSTA2bits.SPEN = 1;
+        RCSTA2 = rcsta;
     }
     
 	// Clear RCIF, if set
     if (uart_index == UART1_INDEX) {
         if (PIR1bits.RC1IF)
-            temp = RC1REG;
+            (void)RC1REG;
     } else if (uart_index == UART2_INDEX) {
         if (PIR3bits.RC2IF)
-            temp = RC1REG;
+            (void)RC2REG;
     }
     
+    // Timer4 times the RS-485 turnaround, off until a transmit starts
+    if (uart_index == UART1_INDEX) {
+        T4CON = UART_TURNAROUND_CKPS;
+        TMR4 = 0;
+        PR4 = UART_TURNAROUND_PERIOD - 1;   // Counts 0..PR4
+        PIE5bits.TMR4IE = 0;
+        PIR5bits.TMR4IF = 0;
+    }
+
 	// Configure Interrupts for UART
 	if (interrupt_control == UART_INTERRUPTS_LOW_PRI || interrupt_control == UART_INTERRUPTS_HIGH_PRI)
 	{
@@ -139,6 +132,7 @@ void UART_Initialize (	unsigned char uart_index,
             if (uart_index == UART1_INDEX) {
             	IPR1bits.RC1IP = 0;
                 IPR1bits.TX1IP = 0;
+                IPR5bits.TMR4IP = 0;            // Enables TX1IE
             } else if (uart_index == UART2_INDEX) {
             	IPR3bits.RC2IP = 0;
                 IPR3bits.TX2IP = 0;
@@ -149,15 +143,22 @@ void UART_Initialize (	unsigned char uart_index,
             if (uart_index == UART1_INDEX) {
                 IPR1bits.RC1IP = 1;
                 IPR1bits.TX1IP = 1;
+                IPR5bits.TMR4IP = 1;            // Enables TX1IE
             } else if (uart_index == UART2_INDEX) {
                 IPR3bits.RC2IP = 1;
                 IPR3bits.TX2IP = 1;
             }
 		}
 
-		// Enable Receive/Transmit Interrupts
-		PIE1bits.RC1IE = 1;
-		//PIE1bits.TX1IE = 1;
+		// Priorities only take effect with IPEN set
+		RCONbits.IPEN = 1;
+
+		// Enable Receive Interrupts
+        if (uart_index == UART1_INDEX) {
+            PIE1bits.RC1IE = 1;
+        } else if (uart_index == UART2_INDEX) {
+            PIE3bits.RC2IE = 1;
+        }
 
 		// Enable Peripheral Device Interrupts
 		INTCONbits.PEIE = 1;
@@ -176,10 +177,44 @@ void UART_Initialize (	unsigned char uart_index,
             PIE3bits.RC2IE = 0;
             PIE3bits.TX2IE = 0;
         }
-
-        EnableTransmitter(uart_index);
 	}
 
+    EnableTransmitter(uart_index);
+}
+
+//===============================================================================
+//	Description:	Loads the baud rate generator from uartSpbrg[]. BRG16 and
+//					BRGH stay as UART_Initialize left them, so the rate can be
+//					changed with the port running.
+//
+//	Params:			UART_INDEX		UCHAR		UART to change
+//					BAUD_CODE		UCHAR		UART_BAUD_CODE_ rate
+//
+//	Returns:			NONE
+//===============================================================================
+void UART_SetBaud(unsigned char uart_index, unsigned char baud_code) {
+    unsigned int spbrg = uartSpbrg[baud_code];
+
+    if (uart_index == UART1_INDEX) {
+        SPBRGH1 = spbrg >> 8;
+        SPBRG1 = (unsigned char)spbrg;
+    } else if (uart_index == UART2_INDEX) {
+        SPBRGH2 = spbrg >> 8;
+        SPBRG2 = (unsigned char)spbrg;
+    }
+}
+
+// Only RX9 and TX9 change, so ADDEN set by the filter is kept
+void UART_SetMode(unsigned char uart_index, unsigned char mode_9bit) {
+    unsigned char bits9 = (mode_9bit == UART_9BIT_MODE);
+
+    if (uart_index == UART1_INDEX) {
+        RCSTA1bits.RX9 = bits9;
+        TXSTA1bits.TX9 = bits9;
+    } else if (uart_index == UART2_INDEX) {
+        RCSTA2bits.RX9 = bits9;
+        TXSTA2bits.TX9 = bits9;
+    }
 }
 
 void EnableTransmitter(unsigned char uart_index) {
@@ -219,15 +254,26 @@ unsigned char IsTransmitterReady(unsigned char uart_index) {
     return FALSE;
 }
 
-void PutChar9 (unsigned char uart_index, unsigned int data) {
-    unsigned char delay;
+// Timer4 from zero, TMR4IF after UART_TURNAROUND_US
+static void UART_TurnaroundStart(void) {
+    TMR4 = 0;
+    PIR5bits.TMR4IF = 0;
+    T4CONbits.TMR4ON = 1;
+}
 
+static void UART_TurnaroundWait(void) {
+    UART_TurnaroundStart();
+    while (!PIR5bits.TMR4IF);
+    T4CONbits.TMR4ON = 0;
+}
+
+// Blocking, for main() only while the interrupt transmit path is idle
+void PutChar9 (unsigned char uart_index, unsigned int data) {
     // Enable the transceiver
     EnableTransceiverTX(uart_index);
 
     // Transceiver turn around time
-    delay = 0;
-    while (delay < 100) { delay++; }
+    UART_TurnaroundWait();
     
     // Ensure we are not currently waiting for a byte to be sent
     while (!_GetTxInterruptFlag(uart_index));
@@ -255,8 +301,7 @@ void PutChar9 (unsigned char uart_index, unsigned int data) {
     }
     
     // Transceiver turn around time
-    delay = 0;
-    while (delay < 100) { delay++; }
+    UART_TurnaroundWait();
 
     DisableTransceiverTX(uart_index);
 }
@@ -381,6 +426,8 @@ unsigned int GetChar9(unsigned char uart_index) {
                 RCSTA2bits.CREN = 0;
                 RCSTA2bits.CREN = 1;
             }
+
+            return data;
         }
     }
     return UART_FAULT_NO_DATA_AVAILABLE;
@@ -390,3 +437,99 @@ unsigned int GetChar9Default() {
     return GetChar9(UART_INDEX_DEFAULT);
 }
 
+//===============================================================================
+//	Description:	Starts draining a transmit FIFO from the TXxIF interrupt.
+//					The RS-485 driver is asserted once for the whole frame;
+//					UART_TransmitService releases it after the last stop bit.
+//					When the driver was off, TXxIE waits for the turnaround
+//					in UART_TurnaroundInterrupt. Call after queueing the
+//					complete frame, from main() or either ISR.
+//
+//	Params:			UART_INDEX		UCHAR		UART to transmit on
+//
+//	Returns:			NONE
+//===============================================================================
+void UART_StartTransmit(unsigned char uart_index) {
+    if (uart_index == UART1_INDEX) {
+        if (PIN_UART1_TX_ENABLE_LATCH != UART1_TX_LATCH_ACTIVE) {
+            EnableTransceiverTX(uart_index);
+
+            // Transceiver turn around time, TMR4IF enables TX1IE
+            UART_TurnaroundStart();
+            PIE5bits.TMR4IE = 1;
+        } else if (!T4CONbits.TMR4ON) {
+            PIE1bits.TX1IE = 1;
+        }
+    } else if (uart_index == UART2_INDEX) {
+        PIE3bits.TX2IE = 1;
+    }
+}
+
+// Called from HighIsr on TMR4IF, the driver has settled. TX1IE is set
+// before the timer stops, see UART_TransmitService.
+void UART_TurnaroundInterrupt(void) {
+    PIE5bits.TMR4IE = 0;
+    PIR5bits.TMR4IF = 0;
+    PIE1bits.TX1IE = 1;
+    T4CONbits.TMR4ON = 0;
+}
+
+//===============================================================================
+//	Description:	TXxIF handler. Loads the next word into TXREG, or masks the
+//					interrupt once the FIFO is empty. TXREG is empty whenever
+//					TXxIF is set, so words go out back-to-back.
+//
+//	Params:			UART_INDEX		UCHAR		UART that raised TXxIF
+//					FIFO			BUFFER16*	Words to transmit
+//
+//	Returns:			NONE
+//===============================================================================
+void UART_TransmitInterrupt(unsigned char uart_index, buffer16* fifo) {
+    unsigned int data;
+
+    if (IsFifoEmpty(fifo)) {
+        // Last word is in the shift register, nothing more to load
+        if (uart_index == UART1_INDEX) {
+            PIE1bits.TX1IE = 0;
+        } else if (uart_index == UART2_INDEX) {
+            PIE3bits.TX2IE = 0;
+        }
+        return;
+    }
+
+    data = FifoDequeue(fifo);
+    if (uart_index == UART1_INDEX) {
+        // 9th bit must be configured before TXREG is loaded
+        TXSTA1bits.TX9D = ((data & 0x0100) == 0x0100);
+        TXREG1 = (unsigned char)(data & 0x00FF);
+    } else if (uart_index == UART2_INDEX) {
+        TXSTA2bits.TX9D = ((data & 0x0100) == 0x0100);
+        TXREG2 = (unsigned char)(data & 0x00FF);
+    }
+}
+
+//===============================================================================
+//	Description:	Releases the RS-485 driver once the transmit engine has
+//					loaded its last word and TRMT shows the stop bit is out.
+//					TRMT has no interrupt, so call this from the main loop.
+//
+//	Params:			UART_INDEX		UCHAR		UART to service
+//
+//	Returns:			TRUE when the transmitter is idle
+//===============================================================================
+unsigned char UART_TransmitService(unsigned char uart_index) {
+    if (uart_index == UART1_INDEX) {
+        // TMR4ON first: once it reads clear, TX1IE is already set
+        if (T4CONbits.TMR4ON || PIE1bits.TX1IE || !TXSTA1bits.TRMT) {
+            return FALSE;
+        }
+        if (PIN_UART1_TX_ENABLE_LATCH == UART1_TX_LATCH_ACTIVE) {
+            DisableTransceiverTX(uart_index);
+        }
+    } else if (uart_index == UART2_INDEX) {
+        if (PIE3bits.TX2IE || !TXSTA2bits.TRMT) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
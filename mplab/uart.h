@@ -20,15 +20,43 @@
 #define UART1_RX_LATCH_ACTIVE           0
 #define UART1_RX_LATCH_INACTIVE         1
 
+// RS-485 driver turnaround ahead of the first word, timed by Timer4 so
+// nothing waits for it. Timer4 counts FOSC/4 through a 1:4 prescaler.
+#define UART_TURNAROUND_US              40
+#define UART_TURNAROUND_PRESCALE        4
+#define UART_TURNAROUND_CKPS            0x01    // T4CKPS for 1:4
+#define UART_TURNAROUND_PERIOD          (UART_TURNAROUND_US * (_XTAL_FREQ / 4000000UL) / UART_TURNAROUND_PRESCALE)
+
+#if UART_TURNAROUND_PERIOD < 1 || UART_TURNAROUND_PERIOD > 256
+#error "UART_TURNAROUND_US is out of Timer4 range"
+#endif
+
 #define UART_INDEX_DEFAULT              1
 #define UART1_INDEX                     1
 #define UART2_INDEX                     2
 
 // Baud Rates
+#define UART_BAUD_460800                460800
 #define UART_BAUD_115200				115200
 #define UART_BAUD_57600					57600
+#define UART_BAUD_38400					38400
 #define UART_BAUD_19200					19200
 #define UART_BAUD_9600					9600
+#define UART_BAUD_4800					4800
+
+// Baud rate codes, index uartSpbrg[]
+#define UART_BAUD_CODE_4800             0
+#define UART_BAUD_CODE_9600             1
+#define UART_BAUD_CODE_19200            2
+#define UART_BAUD_CODE_38400            3
+#define UART_BAUD_CODE_57600            4
+#define UART_BAUD_CODE_115200           5
+#define UART_BAUD_CODE_460800           6   // SPBRG 34, 0.8% slow
+#define UART_BAUD_CODE_COUNT            7
+
+// SPBRGH:SPBRG with BRG16 = BRGH = 1, to the nearest divisor. Constant
+// folded, so no division is left in the firmware.
+#define UART_SPBRG(baud)                (((_XTAL_FREQ / 4) + (baud) / 2) / (baud) - 1)
 
 // 8 or 9 bit mode
 #define UART_8BIT_MODE					0
@@ -44,10 +72,14 @@
 #define UART_FAULT_OVERRUN_ERROR        0x0400
 #define UART_FAULT_NO_DATA_AVAILABLE    0x0800
 
+extern const unsigned int uartSpbrg[UART_BAUD_CODE_COUNT];
+
 void UART_Initialize (	unsigned char uart_index,
-                        unsigned long baud, 
+                        unsigned char baud_code,
 						unsigned char mode_9bit,
 						unsigned char interrupt_control );
+void UART_SetBaud(unsigned char uart_index, unsigned char baud_code);
+void UART_SetMode(unsigned char uart_index, unsigned char mode_9bit);
 void PutChar9 (unsigned char uart_index, unsigned int data);
 void PutChar9Default(unsigned int data);
 void EnableTransmitter(unsigned char uart_index);
@@ -64,4 +96,10 @@ unsigned char IsRxDataAvailable(unsigned char uart_index);
 unsigned int GetChar9(unsigned char uart_index);
 unsigned int GetChar9Default();
 
+// Interrupt driven transmit engine (requires fifo.h)
+void UART_StartTransmit(unsigned char uart_index);
+void UART_TransmitInterrupt(unsigned char uart_index, buffer16* fifo);
+void UART_TurnaroundInterrupt(void);
+unsigned char UART_TransmitService(unsigned char uart_index);
+
 